@@ -12,7 +12,7 @@ project "main"
 
     includedirs { "/usr/include" }
     libdirs { "/usr/lib" }
-    links { "glfw", "GLEW", "GL", "m" }
+    links { "glfw", "GLEW", "GL", "EGL", "z", "m", "pthread" }
 
     postbuildcommands { "./bin/main" }
 
@@ -0,0 +1,225 @@
+#ifndef ANTI_ALIASING_H
+#define ANTI_ALIASING_H
+
+#include <stdio.h>
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include "gl_object.h"
+#include "shader.h"
+#include "window.h"
+
+/** Anti-aliasing for a Window's offscreen target. The frame is drawn into the FBO begin
+  * returns, then resolve puts the result into the window's texture:
+  *     OFF       draws straight into the window
+  *     MSAA_nX   draws into multisampled buffers, resolved with a blit
+  *     FXAA      draws into a single-sampled texture, filtered into the window by a
+  *               full-screen FXAA pass
+  * The intermediate buffers follow the window's texture size, so they only reallocate
+  * when it does, and are released when the mode is switched to OFF. */
+class AntiAliasing
+{
+public:
+
+    enum Mode { OFF, MSAA_2X, MSAA_4X, MSAA_8X, FXAA, NUM_MODES };
+
+    Mode mode = MSAA_4X;
+
+    AntiAliasing()
+        : fxaa(fullScreenVertexSource, fxaaFragmentSource)
+    {
+        glGetIntegerv(GL_MAX_SAMPLES, &maxSamples);
+        emptyVAO = GLVertexArray::create();
+
+        glUseProgram(fxaa.ID);
+        glUniform1i(fxaa.uniform("scene"), 0);
+        glUseProgram(0);
+    }
+
+    static const char *modeName(Mode mode)
+    {
+        static const char *names[NUM_MODES] = { "Off", "MSAA 2x", "MSAA 4x", "MSAA 8x", "FXAA" };
+        return names[mode];
+    }
+
+    // Samples per pixel the mode actually gets, MSAA is capped by GL_MAX_SAMPLES
+    int samples() const
+    {
+        int wanted = mode == MSAA_2X ? 2 : mode == MSAA_4X ? 4 : mode == MSAA_8X ? 8 : 1;
+        return glm::min(wanted, glm::max(maxSamples, 1));
+    }
+
+    // The framebuffer to draw the frame into
+    GLuint begin(const Window &target)
+    {
+        if (mode == OFF)
+        {
+            if (allocatedMode != OFF) release();
+            return target.FBO;
+        }
+        if (mode != allocatedMode || target.textureSize() != allocatedSize) allocate(target.textureSize());
+        return sceneFBO;
+    }
+
+    // Puts the frame drawn since begin into the target's texture
+    void resolve(const Window &target)
+    {
+        if (mode == OFF) return;
+
+        if (mode == FXAA)
+        {
+            glBindFramebuffer(GL_FRAMEBUFFER, target.FBO);
+            glViewport(0, 0, target.width, target.height);
+            glDisable(GL_DEPTH_TEST);
+            glDisable(GL_BLEND);
+
+            glm::vec2 texelSize(1.0f / allocatedSize.x, 1.0f / allocatedSize.y);
+            glUseProgram(fxaa.ID);
+            glUniform2f(fxaa.uniform("texelSize"), texelSize.x, texelSize.y);
+            glUniform2f(fxaa.uniform("uvMax"), (target.width - 0.5f) * texelSize.x, (target.height - 0.5f) * texelSize.y);
+            glActiveTexture(GL_TEXTURE0);
+            glBindTexture(GL_TEXTURE_2D, sceneTexture);
+            glBindVertexArray(emptyVAO);
+            glDrawArrays(GL_TRIANGLES, 0, 3);
+            glBindVertexArray(0);
+            glBindTexture(GL_TEXTURE_2D, 0);
+
+            glEnable(GL_BLEND);
+            glEnable(GL_DEPTH_TEST);
+        }
+        else
+        {
+            glBindFramebuffer(GL_READ_FRAMEBUFFER, sceneFBO);
+            glBindFramebuffer(GL_DRAW_FRAMEBUFFER, target.FBO);
+            glBlitFramebuffer(0, 0, target.width, target.height, 0, 0, target.width, target.height,
+                              GL_COLOR_BUFFER_BIT, GL_NEAREST);
+        }
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    }
+
+private:  // Vertex and fragments shaders
+
+    // One triangle covering the viewport
+    const char *fullScreenVertexSource = R"(
+        #version 330 core
+
+        void main()
+        {
+            vec2 corner = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);
+            gl_Position = vec4(corner * 2.0 - 1.0, 0.0, 1.0);
+        }
+    )";
+
+    // FXAA in its compact form: blend along the local edge direction found from the luma
+    // of the four diagonal neighbours, unless that overshoots the neighbourhood's range
+    const char *fxaaFragmentSource = R"(
+        #version 330 core
+        #define FXAA_REDUCE_MIN (1.0 / 128.0)
+        #define FXAA_REDUCE_MUL (1.0 / 8.0)
+        #define FXAA_SPAN_MAX 8.0
+
+        uniform sampler2D scene;
+        uniform vec2 texelSize;
+        uniform vec2 uvMax;  // Centre of the last texel drawn into, the texture is larger
+
+        out vec4 FragColor;
+
+        vec4 fetch(vec2 uv)
+        {
+            return texture(scene, clamp(uv, 0.5 * texelSize, uvMax));
+        }
+
+        void main()
+        {
+            const vec3 toLuma = vec3(0.299, 0.587, 0.114);
+            vec2 uv = gl_FragCoord.xy * texelSize;
+            vec4 centre = fetch(uv);
+            float lumaNW = dot(fetch(uv + vec2(-1.0, -1.0) * texelSize).rgb, toLuma);
+            float lumaNE = dot(fetch(uv + vec2( 1.0, -1.0) * texelSize).rgb, toLuma);
+            float lumaSW = dot(fetch(uv + vec2(-1.0,  1.0) * texelSize).rgb, toLuma);
+            float lumaSE = dot(fetch(uv + vec2( 1.0,  1.0) * texelSize).rgb, toLuma);
+            float lumaM  = dot(centre.rgb, toLuma);
+            float lumaMin = min(lumaM, min(min(lumaNW, lumaNE), min(lumaSW, lumaSE)));
+            float lumaMax = max(lumaM, max(max(lumaNW, lumaNE), max(lumaSW, lumaSE)));
+
+            vec2 direction = vec2(-((lumaNW + lumaNE) - (lumaSW + lumaSE)), (lumaNW + lumaSW) - (lumaNE + lumaSE));
+            float reduce = max((lumaNW + lumaNE + lumaSW + lumaSE) * 0.25 * FXAA_REDUCE_MUL, FXAA_REDUCE_MIN);
+            float scale = 1.0 / (min(abs(direction.x), abs(direction.y)) + reduce);
+            direction = clamp(direction * scale, -FXAA_SPAN_MAX, FXAA_SPAN_MAX) * texelSize;
+
+            vec4 inner = 0.5 * (fetch(uv - direction / 6.0) + fetch(uv + direction / 6.0));
+            vec4 outer = 0.5 * inner + 0.25 * (fetch(uv - direction * 0.5) + fetch(uv + direction * 0.5));
+            float lumaOuter = dot(outer.rgb, toLuma);
+            FragColor = lumaOuter < lumaMin || lumaOuter > lumaMax ? inner : outer;
+        }
+    )";
+
+private:
+
+    Shader fxaa;
+    GLVertexArray emptyVAO;
+    GLint maxSamples = 0;
+
+    GLFramebuffer sceneFBO;
+    GLTexture sceneTexture;        // FXAA input
+    GLRenderbuffer colourBuffer;   // MSAA colour
+    GLRenderbuffer depthBuffer;
+    Mode allocatedMode = OFF;
+    glm::ivec2 allocatedSize = glm::ivec2(0);
+
+    void allocate(glm::ivec2 size)
+    {
+        allocatedMode = mode;
+        allocatedSize = size;
+        sceneFBO = GLFramebuffer::create();
+        sceneTexture.reset();
+        colourBuffer.reset();
+        depthBuffer = GLRenderbuffer::create();
+
+        glBindFramebuffer(GL_FRAMEBUFFER, sceneFBO);
+        if (mode == FXAA)
+        {
+            sceneTexture = GLTexture::create();
+            glBindTexture(GL_TEXTURE_2D, sceneTexture);
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, size.x, size.y, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+            glBindTexture(GL_TEXTURE_2D, 0);
+            glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, sceneTexture, 0);
+
+            glBindRenderbuffer(GL_RENDERBUFFER, depthBuffer);
+            glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, size.x, size.y);
+        }
+        else
+        {
+            colourBuffer = GLRenderbuffer::create();
+            glBindRenderbuffer(GL_RENDERBUFFER, colourBuffer);
+            glRenderbufferStorageMultisample(GL_RENDERBUFFER, samples(), GL_RGBA8, size.x, size.y);
+            glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, colourBuffer);
+
+            glBindRenderbuffer(GL_RENDERBUFFER, depthBuffer);
+            glRenderbufferStorageMultisample(GL_RENDERBUFFER, samples(), GL_DEPTH_COMPONENT24, size.x, size.y);
+        }
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depthBuffer);
+        glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+        {
+            fprintf(stderr, "Anti-aliasing frame buffer not complete (%s)\n", modeName(mode));
+        }
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    }
+
+    // Frees the intermediate buffers, begin allocates them again for the next mode
+    void release()
+    {
+        allocatedMode = OFF;
+        allocatedSize = glm::ivec2(0);
+        sceneFBO.reset();
+        sceneTexture.reset();
+        colourBuffer.reset();
+        depthBuffer.reset();
+    }
+
+};
+
+#endif
@@ -16,6 +16,12 @@ public:
     glm::mat4 projection, view, projectionView;
     float fovy, zNear, zFar;
 
+    // Set whenever view or projection change, cleared by whoever redraws
+    bool dirty = true;
+
+    // Frustum planes, normal in xyz and offset in w, points inside have dot >= 0
+    glm::vec4 frustum[6];
+
 
     Camera() {}
 
@@ -31,7 +37,7 @@ public:
         , projectionView(projection*view)
         , cachedWindowWidth(windowWidth)
         , cachedWindowHeight(windowHeight)
-    {}
+    { updateFrustum(); }
 
     void onWindowResize(int newWindowWidth, int newWindowHeight)
     {
@@ -76,18 +82,44 @@ public:
         updateProjection();
     }
 
+    bool sphereVisible(glm::vec3 center, float radius) const
+    {
+        for (int i = 0; i < 6; i++)
+            if (glm::dot(glm::vec3(frustum[i].x, frustum[i].y, frustum[i].z), center) + frustum[i].w < -radius)
+                return false;
+        return true;
+    }
+
 private:
 
+    // Gribb-Hartmann: each plane is the last row of projectionView plus or minus another row
+    void updateFrustum()
+    {
+        for (int i = 0; i < 3; i++)
+        {
+            for (int sign = -1; sign <= 1; sign += 2)
+            {
+                glm::vec4 plane;
+                for (int c = 0; c < 4; c++) plane[c] = projectionView[c][3] + sign * projectionView[c][i];
+                frustum[2*i + (sign > 0)] = plane / glm::length(glm::vec3(plane.x, plane.y, plane.z));
+            }
+        }
+    }
+
     void updateView()
     {
         view = glm::lookAt(position, target, upVector);
         projectionView = projection*view;
+        updateFrustum();
+        dirty = true;
     }
 
     void updateProjection()
     {
         projection = glm::perspective(fovy, (float)(cachedWindowWidth) / (float)(cachedWindowHeight), zNear, zFar);
         projectionView = projection*view;
+        updateFrustum();
+        dirty = true;
     }
 
 };
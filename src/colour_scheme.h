@@ -0,0 +1,19 @@
+#ifndef COLOUR_SCHEME_H
+#define COLOUR_SCHEME_H
+
+enum Colour { ORANGE, RED, YELLOW, WHITE, BLUE, GREEN, NUM_COLOURS };
+
+// RGB of every colour, shared by the GL stickers and the CPU nets
+static const float colourScheme[NUM_COLOURS][3] = {
+    { 1.0f, 0.5f, 0.0f },  // orange
+    { 1.0f, 0.0f, 0.0f },  // red
+    { 1.0f, 1.0f, 0.0f },  // yellow
+    { 1.0f, 1.0f, 1.0f },  // white
+    { 0.0f, 0.0f, 1.0f },  // blue
+    { 0.0f, 1.0f, 0.0f },  // green
+};
+
+// Colour of each face in the U R F D L B order of CubieCube, as the 3D cube shows them
+static const Colour faceColours[6] = { YELLOW, ORANGE, GREEN, WHITE, RED, BLUE };
+
+#endif
@@ -7,114 +7,250 @@
 #include <unistd.h>
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
+#include <stddef.h>
+#include <algorithm>
+#include <deque>
+#include <string>
+#include <vector>
 #include <glm/glm.hpp>
-#include "face.h"
-#include "shader.h"
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+#include "colour_scheme.h"
+#include "facelet_cube.h"
+#include "scene_snapshot.h"
+#include "scrambler.h"
+#include "sticker_renderer.h"
 
-#define NUM_FACES 54
-#define NUM_MOVES 12
-#define PRINT_VEC4(v) (printf("(%.2f, %.2f, %.2f, %.2f)\n", (v).x, (v).y, (v).z, (v).w))
+// Seconds per turn, and the size of a sticker relative to its piece
+#define TURN_DURATION 0.15f
+#define PIECE_SCALE 0.85f
 
+// Queued moves turn faster the more are waiting behind them: a turn lasts
+// TURN_DURATION / (1 + waiting / QUEUE_SPEEDUP), and never less than
+// 1 / maxTurnsPerSecond
+#define QUEUE_SPEEDUP 4.0f
+#define DEFAULT_MAX_TPS 30.0f
+
+/** An NxN cube on screen: the sticker state of a FaceletCube plus one StickerInstance
+  * per sticker. Instance i shows sticker i. A turn points the instances of the stickers
+  * it moved back at their previous place along with the turn, and the vertex shader
+  * animates them from there, so a turn costs the same O(N) or O(N^2) as in the state.
+  * Cubes hold no GL objects, renderers draw them from snapshots.
+  *
+  * Moves queue up and play back to back, each starting when the one before ends. The
+  * longer the queue the shorter their turns, and moves on the same axis turning
+  * different layers, such as R L' or U D, turn together. */
 class Cube
 {
-private:  // Vertex and fragments shaders
+public:
+
+    float sideLength;
+
+    // Fastest the queue plays, however long it gets. Moves turning together count once
+    float maxTurnsPerSecond = DEFAULT_MAX_TPS;
+
+    Cube(float sideLength, uint64_t seed = time(NULL), glm::vec3 position = glm::vec3(0.0f), int size = 3)
+        : sideLength(sideLength)
+        , state(size)
+        , scrambler(seed)
+        , position(position)
+    {
+        reset();
+    }
+
+    // Layers per side, N
+    int getSize() const
+    {
+        return state.getSize();
+    }
 
-    const char *vertexShaderSource = R"(
-        #version 330 core
-        layout(location = 0) in vec3 aPos;
-        uniform mat4 mvp;
+    const FaceletCube &getState() const
+    {
+        return state;
+    }
+
+    int numStickers() const
+    {
+        return state.numStickers();
+    }
+
+    const StickerInstance *instanceData() const
+    {
+        return instances.data();
+    }
+
+    // Increases whenever an instance changes. Instances only change when a turn starts,
+    // the vertex shader animates turns from the frame time
+    uint64_t version() const
+    {
+        return changes;
+    }
 
-        void main() {
-            gl_Position = mvp * vec4(aPos, 1.0);
+    // Brings a snapshot taken earlier up to date, copying only the blocks changed since
+    void snapshot(CubeSnapshot &out) const
+    {
+        if (out.instances.size() != instances.size())
+        {
+            out.instances.resize(instances.size());
+            out.blockVersions.assign(blockVersions.size(), 0);
+        }
+        for (size_t b = 0; b < blockVersions.size(); b++)
+        {
+            if (out.blockVersions[b] == blockVersions[b]) continue;
+            size_t first = b * SNAPSHOT_BLOCK, end = std::min(first + SNAPSHOT_BLOCK, instances.size());
+            std::copy(instances.begin() + first, instances.begin() + end, out.instances.begin() + first);
+            out.blockVersions[b] = blockVersions[b];
         }
-    )";
+        out.position = position;
+        out.boundingRadius = boundingRadius();
+    }
 
-    const char *fragmentShaderSource = R"(
-        #version 330 core
-        out vec4 FragColor;
-        uniform vec3 colour;
+    // Turns rotate about this point, the centre of the cube in world space
+    const glm::vec3 &getPosition() const
+    {
+        return position;
+    }
 
-        void main() {
-            FragColor = vec4(colour.xyz, 1.0);
+    void setPosition(glm::vec3 newPosition)
+    {
+        position = newPosition;
+        for (int i = 0; i < numStickers(); i++)
+        {
+            instances[i].origin = glm::vec4(position, 1.0f);
+            markChanged(i);
         }
-    )";
+    }
 
-public:
+    // Radius of the sphere around the position that holds the cube, whatever its turns
+    float boundingRadius() const
+    {
+        return sideLength * 0.8660254f;  // sqrt(3) / 2
+    }
 
-    float sideLength;
+    // Back to the solved state, without animation
+    void reset()
+    {
+        state.reset();
+        writeRestInstances();
+    }
 
-    Face *faces[NUM_FACES];
+    // Jumps to any state of the same size, without animation
+    void setState(const FaceletCube &newState)
+    {
+        if (newState.getSize() != getSize()) return;
+        state = newState;
+        writeRestInstances();
+    }
 
-    Cube(float sideLength)
-        : shader(vertexShaderSource, fragmentShaderSource)
-        , sideLength(sideLength)
+    /** Turns started from now on are stamped with this time, the simulation's clock.
+      * Starts the queued moves due by then, each at the time the previous one ended, so
+      * the queue plays seamlessly however seldom this is called. */
+    void perFrame(double currentTime)
     {
-        srand(time(NULL));
-        
-        // Generate faces
-        int i = 0;
-        for (int f = -1; f <= 1; f += 2)
+        animationTime = currentTime;
+        while (!queue.empty() && queueTime <= currentTime)
         {
-            for (int a = -1; a <= 1; a++)
+            // Moves turning other layers of the same axis join the first
+            size_t group = 1;
+            while (group < queue.size() && queue[group].axis == queue[0].axis)
             {
-                for (int b = -1; b <= 1; b++)
-                {
-                    int faceID = FACE_ID*f;
-                    int ap = POS_ID*a;
-                    int bp = POS_ID*b;
-                    faces[i] = createFace(glm::ivec3(faceID, ap, bp));
-                    faces[i+1] = createFace(glm::ivec3(ap, faceID, bp));
-                    faces[i+2] = createFace(glm::ivec3(ap, bp, faceID));
-                    i += 3;
-                }
+                bool overlaps = false;
+                for (size_t i = 0; i < group; i++)
+                    overlaps |= queue[group].firstLayer <= queue[i].lastLayer && queue[i].firstLayer <= queue[group].lastLayer;
+                if (overlaps) break;
+                group++;
             }
+
+            float duration = glm::max(TURN_DURATION / (1.0f + (queue.size() - group) / QUEUE_SPEEDUP),
+                                      1.0f / maxTurnsPerSecond);
+            for (size_t i = 0; i < group; i++) turn(queue[i]);
+            queue.erase(queue.begin(), queue.begin() + group);
+            writeTurnedInstances(queueTime, duration);
+            queueTime += duration;
         }
     }
 
-    ~Cube()
+    bool isAnimating() const
     {
-        for (int i = 0; i < NUM_FACES; i++)
-        {
-            delete faces[i];
-        }
+        return animationTime < animationEnd;
     }
 
-    void render(glm::mat4 projectionView)
+    // When the latest turn ends, every sticker is at rest from then on
+    double animationEndTime() const
     {
-        for (int i = 0; i < NUM_FACES; i++)
+        return animationEnd;
+    }
+
+    /** Instances hold their turn times as floats, which the vertex shader compares with
+      * FrameUniforms::time: both count from an epoch so they stay precise however long
+      * the clock runs. Moving the epoch rewrites the times of every instance. */
+    void rebase(double newEpoch)
+    {
+        float shift = epoch - newEpoch;
+        for (int i = 0; i < numStickers(); i++)
         {
-            faces[i]->render(projectionView, shader.ID);
+            instances[i].timing.x += shift;
+            markChanged(i);
         }
+        epoch = newEpoch;
+    }
+
+    // Moves waiting for the ones before them to finish
+    int queuedMoves() const
+    {
+        return queue.size();
+    }
+
+    /** Queues any move of LayerMove's notation, it starts at the next perFrame after the
+      * moves before it. False for unknown moves. */
+    bool move(const char *move)
+    {
+        LayerMove layerMove;
+        if (!LayerMove::parse(move, getSize(), layerMove)) return false;
+        this->move(layerMove);
+        return true;
+    }
+
+    void move(const LayerMove &layerMove)
+    {
+        // An idle queue starts again from now
+        if (queue.empty()) queueTime = std::max(queueTime, animationTime);
+        queue.push_back(layerMove);
     }
 
-    void perFrame(float dt)
+    /** Apply a space separated sequence such as "R U2 F' 3Rw" right away, after whatever
+      * was queued. Unknown moves are skipped. */
+    void moveSequence(const char *sequence)
     {
-        for (int i = 0; i < NUM_FACES; i++)
+        std::vector<LayerMove> moves;
+        std::string token;
+        for (const char *c = sequence; ; c++)
         {
-            faces[i]->perFrame(dt);
+            if (*c != ' ' && *c != '\0')
+            {
+                token += *c;
+                continue;
+            }
+            LayerMove layerMove;
+            if (!token.empty() && LayerMove::parse(token.c_str(), getSize(), layerMove)) moves.push_back(layerMove);
+            token.clear();
+            if (*c == '\0') break;
         }
+        moveSequence(moves);
     }
 
-    void move(const char *move)
+    /** All the moves start now, so each sticker only shows the last one that moved it and
+      * its instance is written once, however many moves it takes part in. */
+    void moveSequence(const std::vector<LayerMove> &moves)
     {
-        #define SINGLE_MOVE(STR, COORD, CMP, AXIS) do {          \
-            if (strcmp(move, STR) == 0)                     \
-                for (int i = 0; i < NUM_FACES; i++)         \
-                    if (faces[i]->posID.COORD CMP POS_ID)   \
-                        faces[i]->beginRotation(AXIS);      \
-        } while (0)
-        SINGLE_MOVE("U" , y, >=  , glm::vec3( 0.0f, -1.0f,  0.0f));
-        SINGLE_MOVE("U'", y, >=  , glm::vec3( 0.0f,  1.0f,  0.0f));
-        SINGLE_MOVE("D" , y, <= -, glm::vec3( 0.0f,  1.0f,  0.0f));
-        SINGLE_MOVE("D'", y, <= -, glm::vec3( 0.0f, -1.0f,  0.0f));
-        SINGLE_MOVE("R" , x, <= -, glm::vec3( 1.0f,  0.0f,  0.0f));
-        SINGLE_MOVE("R'", x, <= -, glm::vec3(-1.0f,  0.0f,  0.0f));
-        SINGLE_MOVE("L" , x, >=  , glm::vec3( 1.0f,  0.0f,  0.0f));
-        SINGLE_MOVE("L'", x, >=  , glm::vec3(-1.0f,  0.0f,  0.0f));
-        SINGLE_MOVE("F" , z, <= -, glm::vec3( 0.0f,  0.0f,  1.0f));
-        SINGLE_MOVE("F'", z, <= -, glm::vec3( 0.0f,  0.0f, -1.0f));
-        SINGLE_MOVE("B" , z, >=  , glm::vec3( 0.0f,  0.0f, -1.0f));
-        SINGLE_MOVE("B'", z, >=  , glm::vec3( 0.0f,  0.0f,  1.0f));
+        for (const LayerMove &queued : queue) turn(queued);
+        queue.clear();
+
+        // Moves queued next wait for the sequence's turns to end, rather than cut them short
+        queueTime = std::max(queueTime, animationTime + TURN_DURATION);
+
+        for (const LayerMove &layerMove : moves) turn(layerMove);
+        writeTurnedInstances(animationTime, TURN_DURATION);
     }
 
     void keyCallback(int key)
@@ -133,70 +269,145 @@ public:
         EXECUTE_MOVE(L, "D'");
         EXECUTE_MOVE(I, "R" );
         EXECUTE_MOVE(K, "R'");
-        EXECUTE_MOVE(E, "L" );
-        EXECUTE_MOVE(D, "L'");
+        EXECUTE_MOVE(E, "L'");
+        EXECUTE_MOVE(D, "L" );
         EXECUTE_MOVE(H, "F" );
         EXECUTE_MOVE(G, "F'");
         EXECUTE_MOVE(W, "B" );
         EXECUTE_MOVE(O, "B'");
 
         // Cube rotations
-        #define EXECUTE_ROTATION(KEY, COORD, AXIS) do {    \
-            if (key == GLFW_KEY_ ## KEY)            \
-                for (int i = 0; i < NUM_FACES; i++) \
-                    faces[i]->beginRotation(AXIS);  \
-        } while (0)
-        EXECUTE_ROTATION(        T, x, glm::vec3( 1.0f,  0.0f,  0.0f));  // T: x
-        EXECUTE_ROTATION(        Y, x, glm::vec3( 1.0f,  0.0f,  0.0f));  // Y: x
-        EXECUTE_ROTATION(        V, x, glm::vec3(-1.0f,  0.0f,  0.0f));  // B: x'
-        EXECUTE_ROTATION(        B, x, glm::vec3(-1.0f,  0.0f,  0.0f));  // N: x'
-        EXECUTE_ROTATION(SEMICOLON, y, glm::vec3( 0.0f, -1.0f,  0.0f));  // ;: y
-        EXECUTE_ROTATION(        A, y, glm::vec3( 0.0f,  1.0f,  0.0f));  // A: y'
-        EXECUTE_ROTATION(        P, z, glm::vec3( 0.0f,  0.0f,  1.0f));  // P: z
-        EXECUTE_ROTATION(        Q, z, glm::vec3( 0.0f,  0.0f, -1.0f));  // Q: z'
+        EXECUTE_MOVE(        T, "x" );
+        EXECUTE_MOVE(        Y, "x" );
+        EXECUTE_MOVE(        V, "x'");
+        EXECUTE_MOVE(        B, "x'");
+        EXECUTE_MOVE(SEMICOLON, "y" );
+        EXECUTE_MOVE(        A, "y'");
+        EXECUTE_MOVE(        P, "z" );
+        EXECUTE_MOVE(        Q, "z'");
 
-        // TODO: Wide moves
+        // Wide moves
+        EXECUTE_MOVE(U, "Rw" );
+        EXECUTE_MOVE(M, "Rw'");
+        EXECUTE_MOVE(R, "Lw'");
 
-        // TODO: Slice moves
+        // Slice moves
+        EXECUTE_MOVE(     5, "M" );
+        EXECUTE_MOVE(     6, "M" );
+        EXECUTE_MOVE(     X, "M'");
+        EXECUTE_MOVE(PERIOD, "M'");
     }
 
     void scramble()
     {
-        int moveCount = 20;
-        for (int i = 0; i < moveCount; i++)
-        {
-            int randIndex = rand() % NUM_MOVES;
-            move(moves[randIndex]);
-        }
+        moveSequence(scrambler.next(getSize()).c_str());
     }
 
 private:
 
-    Shader shader;
+    FaceletCube state;
+    Scrambler scrambler;
+    glm::vec3 position;
+
+    std::vector<StickerInstance> instances;
+    std::vector<FaceletCube::StickerMove> moved;
+
+    // The change that last wrote each SNAPSHOT_BLOCK instances, and the latest change
+    std::vector<uint64_t> blockVersions;
+    uint64_t changes = 0;
 
-    const char *moves[12] = { "U", "U'", "D", "D'", "R", "R'", "L", "L'", "F", "F'", "B", "B'" };
+    double animationTime = 0.0;
+    double animationEnd = 0.0;
+    double epoch = 0.0;
 
-    struct {
-        glm::vec3 orange = glm::vec3(1.0f, 0.5f, 0.0f);
-        glm::vec3    red = glm::vec3(1.0f, 0.0f, 0.0f);
-        glm::vec3 yellow = glm::vec3(1.0f, 1.0f, 0.0f);
-        glm::vec3  white = glm::vec3(1.0f, 1.0f, 1.0f);
-        glm::vec3   blue = glm::vec3(0.0f, 0.0f, 1.0f);
-        glm::vec3  green = glm::vec3(0.0f, 1.0f, 0.0f);
-    } colours;
+    // Moves not started yet, and when the first of them starts
+    std::deque<LayerMove> queue;
+    double queueTime = 0.0;
 
-    Face *createFace(glm::ivec3 initialPos)
+    // Stickers moved since the last writeTurnedInstances, with the source and turn of the
+    // last move that moved them. turnedFrom is -1 for the others
+    std::vector<int> turned, turnedFrom, turnedBy;
+    std::vector<glm::vec4> turns;
+
+    // Applies the move to the state and notes the stickers it moved
+    void turn(const LayerMove &layerMove)
+    {
+        moved.clear();
+        state.apply(layerMove, &moved);
+
+        // The turn about the standard frame's axis, in the cube's own coordinates
+        static const glm::vec3 axes[3] = { glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(0.0f, -1.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f) };
+        turns.push_back(layerMove.quarterTurns == 3 ? glm::vec4(-axes[layerMove.axis], 90.0f)
+                                                    : glm::vec4(axes[layerMove.axis], 90.0f * layerMove.quarterTurns));
+
+        turnedFrom.resize(numStickers(), -1);
+        turnedBy.resize(numStickers());
+        for (const FaceletCube::StickerMove &m : moved)
+        {
+            if (turnedFrom[m.destination] < 0) turned.push_back(m.destination);
+            turnedFrom[m.destination] = m.source;
+            turnedBy[m.destination] = turns.size() - 1;
+        }
+    }
+
+    // Every sticker at rest in its place, and nothing left to play
+    void writeRestInstances()
+    {
+        instances.resize(numStickers());
+        blockVersions.resize((numStickers() + SNAPSHOT_BLOCK - 1) / SNAPSHOT_BLOCK);
+        for (int i = 0; i < numStickers(); i++)
+        {
+            instances[i].model = restModel(i);
+            instances[i].turn = glm::vec4(1.0f, 0.0f, 0.0f, 0.0f);
+            instances[i].timing = glm::vec4(0.0f, TURN_DURATION, (float)faceColours[state.colour(i)], 0.0f);
+            instances[i].origin = glm::vec4(position, 1.0f);
+            markChanged(i);
+        }
+        animationEnd = 0.0;
+        queue.clear();
+    }
+
+    // Each moved sticker starts from where its last move found it
+    void writeTurnedInstances(double start, float duration)
     {
-        glm::vec3 *colour;
-        if      (initialPos.x == -FACE_ID) colour = &colours.orange;
-        else if (initialPos.x ==  FACE_ID) colour = &colours.red;
-        else if (initialPos.y == -FACE_ID) colour = &colours.white;
-        else if (initialPos.y ==  FACE_ID) colour = &colours.yellow;
-        else if (initialPos.z == -FACE_ID) colour = &colours.green;
-        else if (initialPos.z ==  FACE_ID) colour = &colours.blue;
-        return new Face(initialPos, colour, sideLength);
+        if (!turns.empty()) animationEnd = std::max(animationEnd, start + duration);
+        for (int sticker : turned)
+        {
+            StickerInstance &instance = instances[sticker];
+            instance.model = restModel(turnedFrom[sticker]);
+            instance.turn = turns[turnedBy[sticker]];
+            instance.timing = glm::vec4(start - epoch, duration, (float)faceColours[state.colour(sticker)], 0.0f);
+            markChanged(sticker);
+            turnedFrom[sticker] = -1;
+        }
+        turned.clear();
+        turns.clear();
+    }
+
+    void markChanged(int sticker)
+    {
+        blockVersions[sticker / SNAPSHOT_BLOCK] = ++changes;
+    }
+
+    // Where the sticker rests when no turn moves it, facing out of its face
+    glm::mat4 restModel(int sticker) const
+    {
+        // The standard frame's X and Z point to R and F, the cube's x and z to L and B
+        glm::ivec3 p = state.position(sticker);
+        glm::ivec3 n = FaceletCube::normal(sticker / (getSize() * getSize()));
+        float unit = sideLength / getSize();
+        float scale = unit * PIECE_SCALE;
+
+        // The quad lies in the xy plane, turned a quarter about y or x for the side faces.
+        // Built directly, this runs for every sticker a turn moves
+        glm::mat4 model(0.0f);
+        if      (n.x != 0) { model[0][2] = -scale; model[1][1] = scale; model[2][0] = scale; }
+        else if (n.y != 0) { model[0][0] = scale; model[1][2] = scale; model[2][1] = -scale; }
+        else               { model[0][0] = scale; model[1][1] = scale; model[2][2] = scale; }
+        model[3] = glm::vec4(-p.x * unit / 2.0f, p.y * unit / 2.0f, -p.z * unit / 2.0f, 1.0f);
+        return model;
     }
 
 };
 
-#endif
\ No newline at end of file
+#endif
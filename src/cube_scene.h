@@ -0,0 +1,95 @@
+#ifndef CUBE_SCENE_H
+#define CUBE_SCENE_H
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+#include <glm/glm.hpp>
+#include "cube.h"
+#include "scene_snapshot.h"
+
+/** Any number of cubes, of any sizes. The scene is the simulation's side: it owns the
+  * cubes and their state, and hands the renderer snapshots of them. */
+class CubeScene
+{
+public:
+
+    CubeScene() {}
+
+    Cube &add(float sideLength, uint64_t seed, glm::vec3 position = glm::vec3(0.0f), int size = 3)
+    {
+        cubes.emplace_back(new Cube(sideLength, seed, position, size));
+        cubes.back()->rebase(epoch);
+        return *cubes.back();
+    }
+
+    // Cubes of the given side length on a rows x columns grid in the xy plane, centred on the origin
+    void addGrid(int rows, int columns, float sideLength, float spacing, uint64_t seed, int size = 3)
+    {
+        for (int r = 0; r < rows; r++)
+        {
+            for (int c = 0; c < columns; c++)
+            {
+                glm::vec3 position((c - (columns - 1) / 2.0f) * spacing, ((rows - 1) / 2.0f - r) * spacing, 0.0f);
+                add(sideLength, seed + cubes.size(), position, size);
+            }
+        }
+    }
+
+    int size() const { return cubes.size(); }
+    Cube &cube(int i) { return *cubes[i]; }
+
+    void perFrame(double currentTime)
+    {
+        for (auto &cube : cubes) cube->perFrame(currentTime);
+    }
+
+    // Every cube's turn times count from the epoch, see Cube::rebase
+    double getEpoch() const
+    {
+        return epoch;
+    }
+
+    void rebase(double newEpoch)
+    {
+        for (auto &cube : cubes) cube->rebase(newEpoch);
+        epoch = newEpoch;
+    }
+
+    int queuedMoves() const
+    {
+        int sum = 0;
+        for (const auto &cube : cubes) sum += cube->queuedMoves();
+        return sum;
+    }
+
+    // Changes whenever a cube changes or one is added
+    uint64_t version() const
+    {
+        uint64_t sum = cubes.size();
+        for (const auto &cube : cubes) sum += cube->version();
+        return sum;
+    }
+
+    // Brings a snapshot taken earlier up to date, copying only what changed since
+    void snapshot(SceneSnapshot &out) const
+    {
+        out.cubes.resize(cubes.size());
+        out.animationEnd = 0.0;
+        for (size_t i = 0; i < cubes.size(); i++)
+        {
+            cubes[i]->snapshot(out.cubes[i]);
+            out.animationEnd = std::max(out.animationEnd, cubes[i]->animationEndTime());
+        }
+        out.epoch = epoch;
+        out.version = version();
+    }
+
+private:
+
+    std::vector<std::unique_ptr<Cube>> cubes;
+    double epoch = 0.0;
+
+};
+
+#endif
@@ -0,0 +1,340 @@
+#ifndef CUBIE_H
+#define CUBIE_H
+
+#include <stdint.h>
+#include <string.h>
+
+// Corners and edges in the usual Kociemba order
+enum Corner { URF, UFL, ULB, UBR, DFR, DLF, DBL, DRB };
+enum Edge { UR, UF, UL, UB, DR, DF, DL, DB, FR, FL, BL, BR };
+
+#define NUM_CORNERS 8
+#define NUM_EDGES 12
+#define NUM_FACE_MOVES 18
+#define NUM_FACELETS 54
+
+#define N_TWIST 2187      // 3^7 corner orientations
+#define N_FLIP 2048       // 2^11 edge orientations
+#define N_SLICE 495       // 12 choose 4 positions of the UD-slice edges
+#define N_CORNER_PERM 40320
+#define N_UD_EDGE_PERM 40320
+#define N_SLICE_PERM 24
+
+/** Cube state on the cubie level. cp[i]/ep[i] is the piece sitting at position i
+  * and co[i]/eo[i] its orientation. Moves are numbered face*3 + (quarter turns - 1)
+  * with the faces in the order U R F D L B, so 0 is U, 1 is U2 and 2 is U'. */
+struct CubieCube
+{
+    int8_t cp[NUM_CORNERS];
+    int8_t co[NUM_CORNERS];
+    int8_t ep[NUM_EDGES];
+    int8_t eo[NUM_EDGES];
+
+    CubieCube()
+    {
+        for (int i = 0; i < NUM_CORNERS; i++) { cp[i] = i; co[i] = 0; }
+        for (int i = 0; i < NUM_EDGES; i++) { ep[i] = i; eo[i] = 0; }
+    }
+
+    bool operator==(const CubieCube &other) const
+    {
+        return memcmp(this, &other, sizeof(CubieCube)) == 0;
+    }
+
+    // Apply b after this cube
+    void multiply(const CubieCube &b)
+    {
+        CubieCube r;
+        for (int i = 0; i < NUM_CORNERS; i++)
+        {
+            r.cp[i] = cp[b.cp[i]];
+            r.co[i] = (co[b.cp[i]] + b.co[i]) % 3;
+        }
+        for (int i = 0; i < NUM_EDGES; i++)
+        {
+            r.ep[i] = ep[b.ep[i]];
+            r.eo[i] = (eo[b.ep[i]] + b.eo[i]) % 2;
+        }
+        *this = r;
+    }
+
+    void move(int m)
+    {
+        for (int i = 0; i <= m % 3; i++)
+            multiply(basicMoves()[m / 3]);
+    }
+
+    static const char *moveName(int m)
+    {
+        static const char *names[NUM_FACE_MOVES] = {
+            "U", "U2", "U'", "R", "R2", "R'", "F", "F2", "F'",
+            "D", "D2", "D'", "L", "L2", "L'", "B", "B2", "B'"
+        };
+        return names[m];
+    }
+
+    static int inverseMove(int m)
+    {
+        return m - m % 3 + 2 - m % 3;
+    }
+
+    // Parse and apply a space separated sequence such as "R U2 F'", false on unknown moves
+    bool applySequence(const char *sequence)
+    {
+        const char *c = sequence;
+        while (*c)
+        {
+            if (*c == ' ') { c++; continue; }
+            int length = 1;
+            while (c[length] && c[length] != ' ') length++;
+
+            int m = 0;
+            while (m < NUM_FACE_MOVES && (strncmp(c, moveName(m), length) != 0 || moveName(m)[length] != '\0')) m++;
+            if (m == NUM_FACE_MOVES) return false;
+            move(m);
+            c += length;
+        }
+        return true;
+    }
+
+    /** Face (0-5 in U R F D L B order) showing on each of the 54 facelets. Facelets are
+      * numbered U1-U9, R1-R9, F1-F9, D1-D9, L1-L9, B1-B9, each face read row by row in
+      * the usual unfolded net:
+      *           U
+      *       L   F   R   B
+      *           D          */
+    void facelets(int8_t *out) const
+    {
+        // Facelets of each corner and edge position, starting with the U or D one
+        static const int8_t cornerFacelet[NUM_CORNERS][3] = {
+            { 8, 9, 20 }, { 6, 18, 38 }, { 0, 36, 47 }, { 2, 45, 11 },
+            { 29, 26, 15 }, { 27, 44, 24 }, { 33, 53, 42 }, { 35, 17, 51 }
+        };
+        static const int8_t edgeFacelet[NUM_EDGES][2] = {
+            { 5, 10 }, { 7, 19 }, { 3, 37 }, { 1, 46 }, { 32, 16 }, { 28, 25 },
+            { 30, 43 }, { 34, 52 }, { 23, 12 }, { 21, 41 }, { 50, 39 }, { 48, 14 }
+        };
+        // Faces of each corner and edge piece, in the same order
+        static const int8_t cornerFaces[NUM_CORNERS][3] = {
+            { 0, 1, 2 }, { 0, 2, 4 }, { 0, 4, 5 }, { 0, 5, 1 },
+            { 3, 2, 1 }, { 3, 4, 2 }, { 3, 5, 4 }, { 3, 1, 5 }
+        };
+        static const int8_t edgeFaces[NUM_EDGES][2] = {
+            { 0, 1 }, { 0, 2 }, { 0, 4 }, { 0, 5 }, { 3, 1 }, { 3, 2 },
+            { 3, 4 }, { 3, 5 }, { 2, 1 }, { 2, 4 }, { 5, 4 }, { 5, 1 }
+        };
+
+        for (int f = 0; f < 6; f++) out[9*f + 4] = f;
+        for (int i = 0; i < NUM_CORNERS; i++)
+            for (int n = 0; n < 3; n++)
+                out[cornerFacelet[i][(n + co[i]) % 3]] = cornerFaces[cp[i]][n];
+        for (int i = 0; i < NUM_EDGES; i++)
+            for (int n = 0; n < 2; n++)
+                out[edgeFacelet[i][(n + eo[i]) % 2]] = edgeFaces[ep[i]][n];
+    }
+
+    // Coordinates
+
+    int twist() const
+    {
+        int t = 0;
+        for (int i = URF; i < DRB; i++) t = 3*t + co[i];
+        return t;
+    }
+
+    void setTwist(int t)
+    {
+        int sum = 0;
+        for (int i = DRB - 1; i >= URF; i--)
+        {
+            co[i] = t % 3;
+            sum += co[i];
+            t /= 3;
+        }
+        co[DRB] = (3 - sum % 3) % 3;
+    }
+
+    int flip() const
+    {
+        int f = 0;
+        for (int i = UR; i < BR; i++) f = 2*f + eo[i];
+        return f;
+    }
+
+    void setFlip(int f)
+    {
+        int sum = 0;
+        for (int i = BR - 1; i >= UR; i--)
+        {
+            eo[i] = f % 2;
+            sum += eo[i];
+            f /= 2;
+        }
+        eo[BR] = sum % 2;
+    }
+
+    // Positions of the FR, FL, BL and BR edges, 0 when they are all in the slice
+    int slice() const
+    {
+        int a = 0, x = 0;
+        for (int j = BR; j >= UR; j--)
+        {
+            if (ep[j] >= FR)
+            {
+                a += binomial(11 - j, x + 1);
+                x++;
+            }
+        }
+        return a;
+    }
+
+    void setSlice(int a)
+    {
+        static const int8_t sliceEdges[4] = { FR, FL, BL, BR };
+        static const int8_t otherEdges[8] = { UR, UF, UL, UB, DR, DF, DL, DB };
+        for (int j = 0; j < NUM_EDGES; j++) ep[j] = -1;
+
+        int x = 4;
+        for (int j = UR; j <= BR; j++)
+        {
+            if (a - binomial(11 - j, x) >= 0)
+            {
+                ep[j] = sliceEdges[4 - x];
+                a -= binomial(11 - j, x);
+                x--;
+            }
+        }
+
+        x = 0;
+        for (int j = UR; j <= BR; j++)
+            if (ep[j] == -1) ep[j] = otherEdges[x++];
+    }
+
+    int cornerPerm() const { return permIndex(cp, NUM_CORNERS); }
+    void setCornerPerm(int idx) { setPerm(cp, NUM_CORNERS, 0, idx); }
+
+    // Only meaningful in phase 2, where the slice edges stay in the slice
+    int udEdgePerm() const { return permIndex(ep, 8); }
+    void setUDEdgePerm(int idx) { setPerm(ep, 8, 0, idx); }
+
+    int slicePerm() const { return permIndex(ep + FR, 4); }
+    void setSlicePerm(int idx) { setPerm(ep + FR, 4, FR, idx); }
+
+    int cornerParity() const { return parity(cp, NUM_CORNERS); }
+    int edgeParity() const { return parity(ep, NUM_EDGES); }
+
+    static const CubieCube *basicMoves()
+    {
+        static CubieCube moves[6];
+        static bool initialized = initBasicMoves(moves);
+        (void)initialized;
+        return moves;
+    }
+
+    static int binomial(int n, int k)
+    {
+        if (n < k || k < 0) return 0;
+        int r = 1;
+        for (int i = 1; i <= k; i++) r = r * (n - k + i) / i;
+        return r;
+    }
+
+private:
+
+    static bool initBasicMoves(CubieCube *moves)
+    {
+        static const int8_t cp[6][8] = {
+            { UBR, URF, UFL, ULB, DFR, DLF, DBL, DRB },  // U
+            { DFR, UFL, ULB, URF, DRB, DLF, DBL, UBR },  // R
+            { UFL, DLF, ULB, UBR, URF, DFR, DBL, DRB },  // F
+            { URF, UFL, ULB, UBR, DLF, DBL, DRB, DFR },  // D
+            { URF, ULB, DBL, UBR, DFR, UFL, DLF, DRB },  // L
+            { URF, UFL, UBR, DRB, DFR, DLF, ULB, DBL },  // B
+        };
+        static const int8_t co[6][8] = {
+            { 0, 0, 0, 0, 0, 0, 0, 0 },
+            { 2, 0, 0, 1, 1, 0, 0, 2 },
+            { 1, 2, 0, 0, 2, 1, 0, 0 },
+            { 0, 0, 0, 0, 0, 0, 0, 0 },
+            { 0, 1, 2, 0, 0, 2, 1, 0 },
+            { 0, 0, 1, 2, 0, 0, 2, 1 },
+        };
+        static const int8_t ep[6][12] = {
+            { UB, UR, UF, UL, DR, DF, DL, DB, FR, FL, BL, BR },
+            { FR, UF, UL, UB, BR, DF, DL, DB, DR, FL, BL, UR },
+            { UR, FL, UL, UB, DR, FR, DL, DB, UF, DF, BL, BR },
+            { UR, UF, UL, UB, DF, DL, DB, DR, FR, FL, BL, BR },
+            { UR, UF, BL, UB, DR, DF, FL, DB, FR, UL, DL, BR },
+            { UR, UF, UL, BR, DR, DF, DL, BL, FR, FL, UB, DB },
+        };
+        static const int8_t eo[6][12] = {
+            { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 },
+            { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 },
+            { 0, 1, 0, 0, 0, 1, 0, 0, 1, 1, 0, 0 },
+            { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 },
+            { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 },
+            { 0, 0, 0, 1, 0, 0, 0, 1, 0, 0, 1, 1 },
+        };
+        for (int f = 0; f < 6; f++)
+        {
+            memcpy(moves[f].cp, cp[f], sizeof(moves[f].cp));
+            memcpy(moves[f].co, co[f], sizeof(moves[f].co));
+            memcpy(moves[f].ep, ep[f], sizeof(moves[f].ep));
+            memcpy(moves[f].eo, eo[f], sizeof(moves[f].eo));
+        }
+        return true;
+    }
+
+    // Lehmer code of p[0..n), only the relative order of the values matters
+    static int permIndex(const int8_t *p, int n)
+    {
+        int idx = 0;
+        for (int i = 0; i < n; i++)
+        {
+            int smaller = 0;
+            for (int j = i + 1; j < n; j++)
+                if (p[j] < p[i]) smaller++;
+            idx = idx * (n - i) + smaller;
+        }
+        return idx;
+    }
+
+    // Inverse of permIndex, filling p[0..n) with offset..offset+n-1
+    static void setPerm(int8_t *p, int n, int offset, int idx)
+    {
+        int8_t digits[NUM_EDGES];
+        for (int i = n - 1; i >= 0; i--)
+        {
+            digits[i] = idx % (n - i);
+            idx /= n - i;
+        }
+
+        bool used[NUM_EDGES] = {};
+        for (int i = 0; i < n; i++)
+        {
+            int k = digits[i];
+            for (int v = 0; v < n; v++)
+            {
+                if (used[v]) continue;
+                if (k-- == 0)
+                {
+                    p[i] = offset + v;
+                    used[v] = true;
+                    break;
+                }
+            }
+        }
+    }
+
+    static int parity(const int8_t *p, int n)
+    {
+        int s = 0;
+        for (int i = 0; i < n; i++)
+            for (int j = i + 1; j < n; j++)
+                if (p[j] < p[i]) s++;
+        return s % 2;
+    }
+
+};
+
+#endif
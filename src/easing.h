@@ -0,0 +1,79 @@
+#ifndef EASING_H
+#define EASING_H
+
+#include <math.h>
+
+/** CSS-style timing curve: the cubic bezier from (0, 0) to (1, 1) with control points
+  * (x1, y1) and (x2, y2), read as progress y over time x. Evaluating it at time x means
+  * solving x(s) = x for the curve parameter s first; using x as s directly, as a plain
+  * bezier evaluation does, distorts the timing. */
+class EasingCurve
+{
+public:
+
+    float x1, y1, x2, y2;
+
+    EasingCurve(float x1, float y1, float x2, float y2)
+        : x1(x1), y1(y1), x2(x2), y2(y2)
+    {}
+
+    // Progress at time x in [0, 1]
+    float operator()(float x) const
+    {
+        if (x <= 0.0f) return 0.0f;
+        if (x >= 1.0f) return 1.0f;
+        return coordinate(y1, y2, parameterAt(x));
+    }
+
+    // size + 1 samples of the curve at evenly spaced times, from 0 to 1
+    void bake(float *table, int size) const
+    {
+        for (int i = 0; i <= size; i++) table[i] = (*this)(i / (float)size);
+    }
+
+private:
+
+    // One coordinate of the curve at parameter s, from its control point coordinates
+    static float coordinate(float c1, float c2, float s)
+    {
+        float u = 1.0f - s;
+        return 3.0f*u*u*s*c1 + 3.0f*u*s*s*c2 + s*s*s;
+    }
+
+    static float derivative(float c1, float c2, float s)
+    {
+        float u = 1.0f - s;
+        return 3.0f*u*u*c1 + 6.0f*u*s*(c2 - c1) + 3.0f*s*s*(1.0f - c2);
+    }
+
+    // Newton's method from s = x, falling back to bisection where the slope vanishes.
+    // x(s) increases monotonically for control points inside [0, 1]
+    float parameterAt(float x) const
+    {
+        float s = x;
+        for (int i = 0; i < 8; i++)
+        {
+            float error = coordinate(x1, x2, s) - x;
+            if (fabsf(error) < 1e-6f) return s;
+            float slope = derivative(x1, x2, s);
+            if (fabsf(slope) < 1e-6f) break;
+            s -= error / slope;
+            if (s < 0.0f || s > 1.0f) break;
+        }
+
+        float low = 0.0f, high = 1.0f;
+        s = x;
+        for (int i = 0; i < 32; i++)
+        {
+            float value = coordinate(x1, x2, s);
+            if (fabsf(value - x) < 1e-6f) break;
+            if (value < x) low = s;
+            else           high = s;
+            s = (low + high) / 2.0f;
+        }
+        return s;
+    }
+
+};
+
+#endif
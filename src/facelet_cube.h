@@ -0,0 +1,297 @@
+#ifndef FACELET_CUBE_H
+#define FACELET_CUBE_H
+
+#include <ctype.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include <glm/glm.hpp>
+
+#define NUM_CUBE_FACES 6
+
+// Outward normal, then the directions of increasing column and row of each face
+static const int faceNormals[NUM_CUBE_FACES][3] = {
+    { 0, 1, 0 }, { 1, 0, 0 }, { 0, 0, 1 }, { 0, -1, 0 }, { -1, 0, 0 }, { 0, 0, -1 }
+};
+static const int faceRights[NUM_CUBE_FACES][3] = {
+    { 1, 0, 0 }, { 0, 0, -1 }, { 1, 0, 0 }, { 1, 0, 0 }, { 0, 0, 1 }, { -1, 0, 0 }
+};
+static const int faceDowns[NUM_CUBE_FACES][3] = {
+    { 0, 0, 1 }, { 0, -1, 0 }, { 0, -1, 0 }, { 0, 0, -1 }, { 0, -1, 0 }, { 0, -1, 0 }
+};
+
+/** A turn of any block of layers. Layers are counted from the R, U or F face along the
+  * X, Y or Z axis, so layer 0 is the outer R, U or F layer and layer N - 1 is L, D or B.
+  * Quarter turns are clockwise as seen from the R, U or F side. */
+struct LayerMove
+{
+    int axis;          // 0 X (R), 1 Y (U), 2 Z (F)
+    int firstLayer;
+    int lastLayer;
+    int quarterTurns;  // 1, 2 or 3
+
+    /** Parses one move of NxN notation for a cube of the given size:
+      *     R U F D L B       the outer layer
+      *     nR                the nth layer alone, a slice: 2R is the layer behind R
+      *     Rw r nRw          the outer two layers, or the outer n
+      *     M E S             every inner layer, turning like L, D and F
+      *     x y z             the whole cube, turning like R, U and F
+      * each followed by nothing, 2, ' or 2'. Returns false for anything else or for
+      * layers the cube doesn't have. */
+    static bool parse(const char *token, int size, LayerMove &move)
+    {
+        const char *c = token;
+        int prefix = 0;
+        while (isdigit(*c)) prefix = prefix * 10 + (*c++ - '0');
+
+        static const char faces[] = "URFDLB";
+        char letter = *c;
+        if (letter == '\0') return false;
+        c++;
+        const char *face = strchr(faces, toupper(letter));
+        bool wide = face && islower(letter);
+        if (face && *c == 'w')
+        {
+            wide = true;
+            c++;
+        }
+
+        // Depth of the block from its own face, as [from, to]
+        int from = 0, to = 0;
+        bool reversed = false;
+        if (face)
+        {
+            int f = face - faces;
+            move.axis = f % 3 == 0 ? 1 : f % 3 == 1 ? 0 : 2;
+            reversed = f >= 3;
+            if (wide) to = (prefix > 0 ? prefix : 2) - 1;
+            else      from = to = (prefix > 0 ? prefix : 1) - 1;
+        }
+        else if (prefix == 0 && (letter == 'M' || letter == 'E' || letter == 'S'))
+        {
+            move.axis = letter == 'M' ? 0 : letter == 'E' ? 1 : 2;
+            reversed = letter != 'S';
+            from = 1;
+            to = size - 2;
+        }
+        else if (prefix == 0 && (letter == 'x' || letter == 'y' || letter == 'z'))
+        {
+            move.axis = letter - 'x';
+            to = size - 1;
+        }
+        else return false;
+
+        move.quarterTurns = 1;
+        if (*c == '2')
+        {
+            move.quarterTurns = 2;
+            c++;
+        }
+        if (*c == '\'')
+        {
+            move.quarterTurns = 4 - move.quarterTurns;
+            c++;
+        }
+        if (*c != '\0' || from > to || to >= size) return false;
+
+        // L, D and B count their layers from the far side and turn the other way round
+        move.firstLayer = reversed ? size - 1 - to : from;
+        move.lastLayer = reversed ? size - 1 - from : to;
+        if (reversed) move.quarterTurns = 4 - move.quarterTurns;
+        return true;
+    }
+};
+
+/** Sticker-level state of an NxN cube, for any N from 1 up. Each face holds N x N
+  * stickers in the facelet order of CubieCube: faces U R F D L B, each read row by row
+  * as seen from outside with U on top (B and D on top for U and D). Turning one layer
+  * moves its 4N side stickers, only the outer layers also spin a face's N^2 stickers.
+  *
+  * Geometry uses the standard frame, X towards R, Y towards U and Z towards F, with
+  * positions doubled so every sticker centre is an integer vector. */
+class FaceletCube
+{
+public:
+
+    // Which sticker moved where, destination is the sticker's index after the move
+    struct StickerMove { int source, destination; };
+
+    FaceletCube(int size = 3)
+        : size(size < 1 ? 1 : size)
+    {
+        reset();
+    }
+
+    int getSize() const
+    {
+        return size;
+    }
+
+    int numStickers() const
+    {
+        return NUM_CUBE_FACES * size * size;
+    }
+
+    // Face (0-5 in U R F D L B order) whose colour shows on the sticker
+    int8_t colour(int sticker) const
+    {
+        return stickers[sticker];
+    }
+
+    void reset()
+    {
+        stickers.resize(numStickers());
+        for (int i = 0; i < numStickers(); i++) stickers[i] = i / (size * size);
+    }
+
+    // Two stickers per byte, for storing many states
+    int packedSize() const
+    {
+        return packedSize(size);
+    }
+
+    static int packedSize(int size)
+    {
+        return (NUM_CUBE_FACES * size * size + 1) / 2;
+    }
+
+    void pack(uint8_t *out) const
+    {
+        memset(out, 0, packedSize());
+        for (int i = 0; i < numStickers(); i++) out[i / 2] |= stickers[i] << (4 * (i % 2));
+    }
+
+    void unpack(const uint8_t *in)
+    {
+        for (int i = 0; i < numStickers(); i++) stickers[i] = (in[i / 2] >> (4 * (i % 2))) & 0xF;
+    }
+
+    bool isSolved() const
+    {
+        for (int i = 0; i < numStickers(); i++)
+            if (stickers[i] != stickers[i - i % (size * size)]) return false;
+        return true;
+    }
+
+    /** Applies the move. Every sticker it moves is appended to moved when given, in
+      * O(N) per layer plus O(N^2) for each outer layer. */
+    void apply(const LayerMove &move, std::vector<StickerMove> *moved = NULL)
+    {
+        touched.clear();
+        for (int layer = move.firstLayer; layer <= move.lastLayer; layer++)
+            collectLayer(move.axis, layer, move.quarterTurns);
+
+        // Gather every source colour before writing, the destinations overlap the sources
+        colours.resize(touched.size());
+        for (size_t i = 0; i < touched.size(); i++) colours[i] = stickers[touched[i].source];
+        for (size_t i = 0; i < touched.size(); i++) stickers[touched[i].destination] = colours[i];
+        if (moved) moved->insert(moved->end(), touched.begin(), touched.end());
+    }
+
+    // Doubled centre of the sticker, the cube spanning [-N, N] on every axis
+    glm::ivec3 position(int sticker) const
+    {
+        int face = sticker / (size * size);
+        int row = sticker % (size * size) / size, column = sticker % size;
+        return faceVector(faceNormals, face) * size + faceVector(faceRights, face) * (2*column - (size - 1))
+             + faceVector(faceDowns, face) * (2*row - (size - 1));
+    }
+
+    static glm::ivec3 normal(int face)
+    {
+        return faceVector(faceNormals, face);
+    }
+
+private:
+
+    int size;
+    std::vector<int8_t> stickers;
+
+    // Scratch space for apply
+    std::vector<StickerMove> touched;
+    std::vector<int8_t> colours;
+
+    static glm::ivec3 faceVector(const int (*table)[3], int face)
+    {
+        return glm::ivec3(table[face][0], table[face][1], table[face][2]);
+    }
+
+    // glm::dot only takes floating point vectors
+    static int dot(glm::ivec3 v, const int *axis)
+    {
+        return v.x * axis[0] + v.y * axis[1] + v.z * axis[2];
+    }
+
+    int index(int face, int row, int column) const
+    {
+        return (face * size + row) * size + column;
+    }
+
+    // Inverse of position and normal
+    int stickerAt(glm::ivec3 normal, glm::ivec3 position) const
+    {
+        int face = 0;
+        while (faceVector(faceNormals, face) != normal) face++;
+        int column = (dot(position, faceRights[face]) + size - 1) / 2;
+        int row = (dot(position, faceDowns[face]) + size - 1) / 2;
+        return index(face, row, column);
+    }
+
+    // Clockwise quarter turns seen from the positive end of the axis
+    static glm::ivec3 rotate(glm::ivec3 v, int axis, int quarterTurns)
+    {
+        for (int i = 0; i < quarterTurns; i++)
+        {
+            if      (axis == 0) v = glm::ivec3(v.x, v.z, -v.y);
+            else if (axis == 1) v = glm::ivec3(-v.z, v.y, v.x);
+            else                v = glm::ivec3(v.y, -v.x, v.z);
+        }
+        return v;
+    }
+
+    int destination(int sticker, int axis, int quarterTurns) const
+    {
+        int face = sticker / (size * size);
+        return stickerAt(rotate(normal(face), axis, quarterTurns), rotate(position(sticker), axis, quarterTurns));
+    }
+
+    /** Collects count stickers from start on, stride apart within one face. Their
+      * destinations lie on a line of another face, so two of them give all the others. */
+    void collectLine(int start, int stride, int count, int axis, int quarterTurns)
+    {
+        int first = destination(start, axis, quarterTurns);
+        int step = count > 1 ? destination(start + stride, axis, quarterTurns) - first : 0;
+        for (int i = 0; i < count; i++)
+            touched.push_back({ start + i * stride, first + i * step });
+    }
+
+    void collectLayer(int axis, int layer, int quarterTurns)
+    {
+        // Side stickers of the layer sit at this doubled coordinate along the axis
+        int coordinate = size - 1 - 2 * layer;
+        for (int face = 0; face < NUM_CUBE_FACES; face++)
+        {
+            int along = faceNormals[face][axis];
+            if (along != 0)
+            {
+                // Outer layers carry their whole face
+                if ((along > 0 && layer == 0) || (along < 0 && layer == size - 1))
+                    for (int row = 0; row < size; row++)
+                        collectLine(index(face, row, 0), 1, size, axis, quarterTurns);
+                continue;
+            }
+
+            // The strip is a column when columns run along the axis, a row otherwise
+            int sign = faceRights[face][axis];
+            bool column = sign != 0;
+            if (!column) sign = faceDowns[face][axis];
+            int fixed = (sign * coordinate + size - 1) / 2;
+            if (column) collectLine(index(face, 0, fixed), size, size, axis, quarterTurns);
+            else        collectLine(index(face, fixed, 0), 1, size, axis, quarterTurns);
+        }
+    }
+
+};
+
+#endif
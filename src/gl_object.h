@@ -0,0 +1,79 @@
+#ifndef GL_OBJECT_H
+#define GL_OBJECT_H
+
+#include <GL/glew.h>
+
+/** Move-only owner of one OpenGL object name. The name is deleted when the owner goes
+  * out of scope, so owners must not outlive the context. Converts to GLuint so it can
+  * be passed straight to the gl* calls. */
+template <typename Traits>
+class GLObject
+{
+public:
+
+    GLObject() : ID(0) {}
+
+    ~GLObject() { reset(); }
+
+    GLObject(GLObject &&other) : ID(other.ID) { other.ID = 0; }
+
+    GLObject &operator=(GLObject &&other)
+    {
+        if (this != &other)
+        {
+            reset();
+            ID = other.ID;
+            other.ID = 0;
+        }
+        return *this;
+    }
+
+    GLObject(const GLObject &) = delete;
+    GLObject &operator=(const GLObject &) = delete;
+
+    static GLObject create()
+    {
+        GLObject object;
+        object.ID = Traits::create();
+        return object;
+    }
+
+    void reset()
+    {
+        if (ID) Traits::destroy(ID);
+        ID = 0;
+    }
+
+    operator GLuint() const { return ID; }
+
+private:
+
+    GLuint ID;
+
+};
+
+#define GL_OBJECT_TRAITS(NAME, GEN, DELETE)                                    \
+    struct NAME {                                                              \
+        static GLuint create() { GLuint id; GEN(1, &id); return id; }          \
+        static void destroy(GLuint id) { DELETE(1, &id); }                     \
+    }
+GL_OBJECT_TRAITS(GLBufferTraits, glGenBuffers, glDeleteBuffers);
+GL_OBJECT_TRAITS(GLVertexArrayTraits, glGenVertexArrays, glDeleteVertexArrays);
+GL_OBJECT_TRAITS(GLTextureTraits, glGenTextures, glDeleteTextures);
+GL_OBJECT_TRAITS(GLFramebufferTraits, glGenFramebuffers, glDeleteFramebuffers);
+GL_OBJECT_TRAITS(GLRenderbufferTraits, glGenRenderbuffers, glDeleteRenderbuffers);
+
+struct GLProgramTraits
+{
+    static GLuint create() { return glCreateProgram(); }
+    static void destroy(GLuint id) { glDeleteProgram(id); }
+};
+
+typedef GLObject<GLBufferTraits> GLBuffer;
+typedef GLObject<GLVertexArrayTraits> GLVertexArray;
+typedef GLObject<GLTextureTraits> GLTexture;
+typedef GLObject<GLFramebufferTraits> GLFramebuffer;
+typedef GLObject<GLRenderbufferTraits> GLRenderbuffer;
+typedef GLObject<GLProgramTraits> GLProgram;
+
+#endif
@@ -5,8 +5,10 @@
 #include "imgui/imgui_impl_glfw.h"
 #include "imgui/imgui_impl_opengl3.h"
 
-#include "cube.h"
+#include "anti_aliasing.h"
 #include "camera.h"
+#include "profiler.h"
+#include "stream_buffer.h"
 
 class GUI
 {
@@ -14,9 +16,8 @@ public:
 
     GUI() {}
 
-    GUI(Cube *cube, Camera *camera)
-        : cube(cube)
-        , camera(camera)
+    GUI(Camera *camera)
+        : camera(camera)
     {}
 
     void show()
@@ -24,11 +25,126 @@ public:
         cameraSettings();
     }
 
+    // Timings and GPU traffic of the renderer, with the settings that change them. Returns
+    // true when a setting changed and the cube has to be drawn again
+    bool profiler(const Profiler &timings, const StreamBuffer &uploads, AntiAliasing &antiAliasing)
+    {
+        ImGui::Begin("Profiler");
+
+        bool changed = false;
+        if (ImGui::BeginCombo("Anti-aliasing", AntiAliasing::modeName(antiAliasing.mode)))
+        {
+            for (int m = 0; m < AntiAliasing::NUM_MODES; m++)
+            {
+                AntiAliasing::Mode mode = (AntiAliasing::Mode)m;
+                if (ImGui::Selectable(AntiAliasing::modeName(mode), mode == antiAliasing.mode) && mode != antiAliasing.mode)
+                {
+                    antiAliasing.mode = mode;
+                    changed = true;
+                }
+            }
+            ImGui::EndCombo();
+        }
+
+        // Last, median and 99th percentile of every scope, then the history of its GPU time,
+        // or CPU time if it has none. The current frame is still running, so everything
+        // shown ends with the previous one, or the one before for GPU times
+        int cpuLast = (timings.slot() + PROFILER_HISTORY - 1) % PROFILER_HISTORY;
+        int gpuLast = (timings.slot() + PROFILER_HISTORY - PROFILER_QUERY_BUFFERS) % PROFILER_HISTORY;
+        if (ImGui::BeginTable("Scopes", 4, ImGuiTableFlags_RowBg | ImGuiTableFlags_SizingStretchProp))
+        {
+            ImGui::TableSetupColumn("Scope (ms)");
+            ImGui::TableSetupColumn("Last");
+            ImGui::TableSetupColumn("p50");
+            ImGui::TableSetupColumn("p99");
+            ImGui::TableHeadersRow();
+            for (const Profiler::Scope &scope : timings.scopes)
+            {
+                scopeRow(scope.name, scope.cpuMs, cpuLast);
+                if (scope.gpu) scopeRow("  GPU", scope.gpuMs, gpuLast);
+            }
+            ImGui::EndTable();
+        }
+        for (const Profiler::Scope &scope : timings.scopes)
+        {
+            PlotHistory history = { scope.gpu ? scope.gpuMs : scope.cpuMs, scope.gpu ? gpuLast : cpuLast };
+            char label[64];
+            snprintf(label, sizeof(label), "%s%s", scope.name, scope.gpu ? " (GPU)" : "");
+            ImGui::PlotLines(label, PlotHistory::get, &history, PROFILER_HISTORY - PROFILER_QUERY_BUFFERS,
+                             0, NULL, 0.0f, FLT_MAX, ImVec2(0, 40));
+        }
+        ImGui::Separator();
+
+        // Upload rate over the last half second or more
+        double now = ImGui::GetTime();
+        if (now - rateStart >= 0.5)
+        {
+            uploadRate = (uploads.totalBytes - rateStartBytes) / (now - rateStart);
+            rateStart = now;
+            rateStartBytes = uploads.totalBytes;
+        }
+        ImGui::Text("Instance uploads (%s)", uploads.isPersistent() ? "persistent map" : "unsynchronized map");
+        ImGui::Text("  %.1f KB last frame, %.2f MB/s", uploads.lastFrameBytes / 1024.0, uploadRate / (1024.0 * 1024.0));
+        ImGui::Text("  %d fence waits", uploads.fenceWaits);
+
+        ImGui::End();
+        return changed;
+    }
+
+    // Scrubber over a sequence of length moves. Returns true when position changed
+    bool timeline(int length, int &position)
+    {
+        ImGui::Begin("Timeline");
+
+        int previous = position;
+        if (ImGui::ArrowButton("##back", ImGuiDir_Left) && position > 0) position--;
+        ImGui::SameLine();
+        if (ImGui::ArrowButton("##forward", ImGuiDir_Right) && position < length) position++;
+        ImGui::SameLine();
+        ImGui::SetNextItemWidth(-FLT_MIN);
+        ImGui::SliderInt("##move", &position, 0, length, "Move %d");
+
+        ImGui::End();
+        return position != previous;
+    }
+
 private:
 
-    Cube *cube;
     Camera *camera;
 
+    // Oldest to newest sample of a profiler history ending at slot last, frames a scope
+    // didn't run in drawn as 0
+    struct PlotHistory
+    {
+        const float *samples;
+        int last;
+
+        static float get(void *data, int i)
+        {
+            const PlotHistory *history = (const PlotHistory*)data;
+            float sample = history->samples[(history->last + 1 + PROFILER_QUERY_BUFFERS + i) % PROFILER_HISTORY];
+            return sample < 0.0f ? 0.0f : sample;
+        }
+    };
+
+    double rateStart = 0.0, uploadRate = 0.0;
+    uint64_t rateStartBytes = 0;
+
+    // The last sample is the one of the given history slot, which a scope may not have
+    void scopeRow(const char *name, const float *samples, int last)
+    {
+        ImGui::TableNextRow();
+        ImGui::TableNextColumn();
+        ImGui::TextUnformatted(name);
+        ImGui::TableNextColumn();
+        if (samples[last] >= 0.0f) ImGui::Text("%.3f", samples[last]);
+        else                       ImGui::TextUnformatted("-");
+        ImGui::TableNextColumn();
+        ImGui::Text("%.3f", Profiler::percentile(samples, 0.5f));
+        ImGui::TableNextColumn();
+        ImGui::Text("%.3f", Profiler::percentile(samples, 0.99f));
+    }
+
     void cameraSettings()
     {
         ImGui::Begin("Camera Settings");
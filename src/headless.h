@@ -0,0 +1,124 @@
+#ifndef HEADLESS_H
+#define HEADLESS_H
+
+// Keep X11 out, its macros clash with ordinary names
+#define EGL_NO_X11
+#define MESA_EGL_NO_X11_HEADERS
+#include <GL/glew.h>
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <stdio.h>
+#include <string.h>
+
+/** OpenGL 3.3 core context without a window, for machines with no display. Prefers
+  * Mesa's surfaceless platform (llvmpipe needs no GPU nor X server) and falls back to
+  * the default EGL display with a tiny pbuffer. All drawing goes to FBOs anyway. */
+class HeadlessContext
+{
+public:
+
+    HeadlessContext() {}
+
+    ~HeadlessContext()
+    {
+        if (display == EGL_NO_DISPLAY) return;
+        eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+        if (context != EGL_NO_CONTEXT) eglDestroyContext(display, context);
+        if (surface != EGL_NO_SURFACE) eglDestroySurface(display, surface);
+        eglTerminate(display);
+    }
+
+    HeadlessContext(const HeadlessContext &) = delete;
+    HeadlessContext &operator=(const HeadlessContext &) = delete;
+
+    // Creates the context, makes it current and loads the GL functions
+    bool create()
+    {
+        if (!createSurfaceless() && !createPbuffer())
+        {
+            fprintf(stderr, "Error: Failed to create a headless EGL context (0x%x)\n", eglGetError());
+            return false;
+        }
+
+        // GLEW built for GLX reports the missing X display after it has already loaded
+        // the GL entry points, which is all this context needs
+        glewExperimental = GL_TRUE;
+        GLenum error = glewInit();
+        if (error != GLEW_OK && error != GLEW_ERROR_NO_GLX_DISPLAY)
+        {
+            fprintf(stderr, "Error: Failed to initialize GLEW: %s\n", glewGetErrorString(error));
+            return false;
+        }
+        return true;
+    }
+
+private:
+
+    EGLDisplay display = EGL_NO_DISPLAY;
+    EGLContext context = EGL_NO_CONTEXT;
+    EGLSurface surface = EGL_NO_SURFACE;
+
+    bool createSurfaceless()
+    {
+        const char *clientExtensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+        if (clientExtensions == NULL || strstr(clientExtensions, "EGL_MESA_platform_surfaceless") == NULL)
+            return false;
+
+        PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay =
+            (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+        if (getPlatformDisplay == NULL) return false;
+
+        EGLDisplay candidate = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+        if (!initialize(candidate)) return false;
+
+        // Surfaceless contexts need no config either
+        if (strstr(eglQueryString(display, EGL_EXTENSIONS), "EGL_KHR_no_config_context") == NULL)
+            return false;
+        return createContext(EGL_NO_CONFIG_KHR) && eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context);
+    }
+
+    bool createPbuffer()
+    {
+        if (display == EGL_NO_DISPLAY && !initialize(eglGetDisplay(EGL_DEFAULT_DISPLAY)))
+            return false;
+
+        const EGLint configAttributes[] = {
+            EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+            EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+            EGL_RED_SIZE, 8, EGL_GREEN_SIZE, 8, EGL_BLUE_SIZE, 8, EGL_ALPHA_SIZE, 8,
+            EGL_NONE
+        };
+        EGLConfig config;
+        EGLint count = 0;
+        if (!eglChooseConfig(display, configAttributes, &config, 1, &count) || count == 0)
+            return false;
+
+        const EGLint surfaceAttributes[] = { EGL_WIDTH, 1, EGL_HEIGHT, 1, EGL_NONE };
+        surface = eglCreatePbufferSurface(display, config, surfaceAttributes);
+        if (surface == EGL_NO_SURFACE) return false;
+
+        return createContext(config) && eglMakeCurrent(display, surface, surface, context);
+    }
+
+    bool initialize(EGLDisplay candidate)
+    {
+        if (candidate == EGL_NO_DISPLAY || !eglInitialize(candidate, NULL, NULL)) return false;
+        display = candidate;
+        return eglBindAPI(EGL_OPENGL_API);
+    }
+
+    bool createContext(EGLConfig config)
+    {
+        const EGLint contextAttributes[] = {
+            EGL_CONTEXT_MAJOR_VERSION, 3,
+            EGL_CONTEXT_MINOR_VERSION, 3,
+            EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+            EGL_NONE
+        };
+        context = eglCreateContext(display, config, EGL_NO_CONTEXT, contextAttributes);
+        return context != EGL_NO_CONTEXT;
+    }
+
+};
+
+#endif
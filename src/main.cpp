@@ -10,20 +10,46 @@
 #include "imgui/imgui_impl_glfw.h"
 #include "imgui/imgui_impl_opengl3.h"
 
+#include "anti_aliasing.h"
 #include "cube.h"
+#include "cube_scene.h"
+#include "scene_renderer.h"
+#include "simulation.h"
 #include "window.h"
 #include "gui.h"
 #include "camera.h"
+#include "profiler.h"
+#include "scramble_generator.h"
+#include "headless.h"
+#include "state_renderer.h"
+#include "replay.h"
+#include "timeline.h"
+#include "net_renderer.h"
+#include "self_test.h"
 
 #define WINDOW_WIDTH 1000
 #define WINDOW_HEIGHT 800
 
+// Idle mode: frames ImGui gets to settle after the last input, and how long to sleep
+// waiting for input once everything is at rest
+#define GUI_SETTLE_FRAMES 3
+#define IDLE_WAIT_TIMEOUT 0.5
+
+// Grid view: distance between cube centres, and turns per cube per second
+#define GRID_SPACING 1.5f
+#define GRID_TURN_RATE 1.0f
+
 Window gameWindow;
 Camera camera;
 // Cube cube;
 GUI cubeGUI;
 
 void initImGui(GLFWwindow *window);
+bool readFile(const char *path, std::string &contents);
+int generateScrambles(int argc, char **argv);
+int renderStates(int argc, char **argv);
+int renderNets(int argc, char **argv);
+int packReplays(int argc, char **argv);
 
 void windowResizeCallback(int newWidth, int newHeight)
 {
@@ -37,14 +63,35 @@ void keyCallback(GLFWwindow *window, int key, int scancode, int action, int mods
         glfwSetWindowShouldClose(window, true);
     }
 
-    Cube *cube = static_cast<Cube*>(glfwGetWindowUserPointer(window));
-    if (cube && action == GLFW_PRESS)
+    // Every cube of the scene follows the keyboard, on the simulation thread
+    Simulation *simulation = static_cast<Simulation*>(glfwGetWindowUserPointer(window));
+    if (simulation && action == GLFW_PRESS)
     {
-        cube->keyCallback(key);
+        simulation->postKey(key);
     }
 }
 
-void gameEvents()
+// Random turns on random cubes, GRID_TURN_RATE per cube per second on average. All of
+// its state is here, so a grid with the same seed turns the same way every run
+struct GridAnimation
+{
+    Random rng;
+    double pendingTurns = 0.0;
+
+    GridAnimation(uint64_t seed)
+        : rng(seed)
+    {}
+
+    void update(CubeScene &scene, double dt)
+    {
+        pendingTurns += GRID_TURN_RATE * scene.size() * dt;
+        for (; pendingTurns >= 1.0; pendingTurns -= 1.0)
+            scene.cube(rng.below(scene.size())).move(CubieCube::moveName(rng.below(NUM_FACE_MOVES)));
+    }
+};
+
+// Returns true when the game view changed size
+bool gameEvents(double currentTime)
 {
     ImVec2 windowSize = ImGui::GetContentRegionAvail();
     
@@ -53,13 +100,78 @@ void gameEvents()
     bool windowChangedSize = windowSize.x != lastWindowSize.x || windowSize.y != lastWindowSize.y;
     if (windowChangedSize)
     {
-        gameWindow.updateDimensions((int)windowSize.x, (int)windowSize.y);
+        gameWindow.updateDimensions((int)windowSize.x, (int)windowSize.y, currentTime);
     }
     lastWindowSize = windowSize;
+    bool shrunk = gameWindow.perFrame(currentTime);
+    return windowChangedSize || shrunk;
 }
 
 int main(int argc, char **argv)
 {
+    // Batch modes run without a window
+    if (argc > 1 && strcmp(argv[1], "--scrambles") == 0)
+    {
+        return generateScrambles(argc, argv);
+    }
+    if (argc > 1 && strcmp(argv[1], "--render") == 0)
+    {
+        return renderStates(argc, argv);
+    }
+    if (argc > 1 && strcmp(argv[1], "--nets") == 0)
+    {
+        return renderNets(argc, argv);
+    }
+    if (argc > 1 && strcmp(argv[1], "--pack-replays") == 0)
+    {
+        return packReplays(argc, argv);
+    }
+    if (argc > 1 && strcmp(argv[1], "--self-test") == 0)
+    {
+        return SelfTest().run() == 0 ? 0 : 1;
+    }
+
+    // --grid N shows N x N cubes turning on their own, --layers N makes them NxN cubes,
+    // --tps N caps how fast queued moves play, --timeline FILE loads a move sequence to scrub,
+    // --replay FILE [--solve I] plays solve I of a replay archive as it was recorded,
+    // --seed S fixes the scrambles and the grid's moves, for runs that repeat
+    int gridSize = 1, layers = 3;
+    uint64_t seed = time(NULL);
+    float maxTurnsPerSecond = DEFAULT_MAX_TPS;
+    const char *timelinePath = NULL;
+    const char *replayPath = NULL;
+    uint64_t replaySolve = 0;
+    for (int i = 1; i + 1 < argc; i++)
+    {
+        if      (strcmp(argv[i], "--grid") == 0)     gridSize = glm::max(atoi(argv[++i]), 1);
+        else if (strcmp(argv[i], "--layers") == 0)   layers = glm::max(atoi(argv[++i]), 1);
+        else if (strcmp(argv[i], "--tps") == 0)      maxTurnsPerSecond = glm::max((float)atof(argv[++i]), 1.0f);
+        else if (strcmp(argv[i], "--timeline") == 0) timelinePath = argv[++i];
+        else if (strcmp(argv[i], "--replay") == 0)   replayPath = argv[++i];
+        else if (strcmp(argv[i], "--solve") == 0)    replaySolve = strtoull(argv[++i], NULL, 10);
+        else if (strcmp(argv[i], "--seed") == 0)     seed = strtoull(argv[++i], NULL, 10);
+    }
+
+    // The archive stays mapped while the solve plays, its moves are decoded as they come due
+    ReplayArchive replays;
+    ReplayPlayer replay;
+    if (replayPath)
+    {
+        if (!replays.open(replayPath) || !replay.load(replays, replaySolve)) return 1;
+        layers = replay.cubeSize();
+        printf("Replaying solve %llu of %llu\n", (unsigned long long)replaySolve, (unsigned long long)replays.size());
+    }
+
+    // The timeline is immutable once built, but for its position, which only the simulation touches
+    Timeline timeline;
+    if (timelinePath)
+    {
+        std::string sequence;
+        if (!readFile(timelinePath, sequence)) return 1;
+        int moves = timeline.build(sequence.c_str(), FaceletCube(layers));
+        printf("Timeline of %d moves\n", moves);
+    }
+
     // Intialize GLFW
     if (!glfwInit())
     {
@@ -67,8 +179,7 @@ int main(int argc, char **argv)
         return -1;
     }
 
-    // Create GLFW window
-    glfwWindowHint(GLFW_SAMPLES, 4);
+    // Create GLFW window. Only ImGui draws to it, the cube's anti-aliasing happens offscreen
     GLFWwindow *window = glfwCreateWindow(WINDOW_WIDTH, WINDOW_HEIGHT, "float", NULL, NULL);
     if (window == NULL)
     {
@@ -82,7 +193,7 @@ int main(int argc, char **argv)
 
     glewInit();
 
-    // OpenGL Settings
+    // OpenGL Settings, multisampling applies to the anti-aliasing buffers
     glEnable(GL_MULTISAMPLE);
     glEnable(GL_DEPTH_TEST);
     glDepthFunc(GL_LESS);
@@ -93,82 +204,166 @@ int main(int argc, char **argv)
     gameWindow = Window(WINDOW_WIDTH, WINDOW_HEIGHT, windowResizeCallback);
 
 
-    // Camera
+    // Camera, backed off far enough to frame the whole grid
     glm::vec3 cameraPos(0.0f, 2.0f, -2.0f);
     glm::vec3 cameraTarget(0.0f, 0.0f, 0.0f);
+    if (gridSize > 1)
+    {
+        float distance = 1.2f * gridSize * GRID_SPACING / 2.0f / tanf(glm::radians(45.0f) / 2.0f);
+        cameraPos = glm::vec3(0.0f, 0.3f * distance, -distance);
+    }
     camera = Camera(cameraPos, cameraTarget, gameWindow.width, gameWindow.height);
 
-    // Create cube and bind it to the window (so we can directly update the cube using keyboard interrupts)
-    Cube cube(1.0f);
-    glfwSetWindowUserPointer(window, &cube);
-
-    // Create GUI instance
-    cubeGUI = GUI(&cube, &camera);
-
-    float t = 0.0f;
-    glm::ivec2 lastFBOSize((int)gameWindow.width, (int)gameWindow.height);
-    while (!glfwWindowShouldClose(window))
+    // GL objects are released at the end of this scope, while the context still exists
     {
-        glfwPollEvents();
-
-        // Start the Dear ImGui frame
-        ImGui_ImplOpenGL3_NewFrame();
-        ImGui_ImplGlfw_NewFrame();
-        ImGui::NewFrame();
-        ImGui::DockSpaceOverViewport(0, ImGui::GetMainViewport());
-
-        // cubeGUI.show();
-
-        // Calculate dt
-        static float lastFrame = 0.0f;
-        float currentFrame = glfwGetTime();
-        float dt = currentFrame - lastFrame;
-        lastFrame = currentFrame;
-
-        // Get the size of the ImGui window
-        ImGui::SetNextWindowDockID(ImGui::GetID("DockSpace"), ImGuiCond_FirstUseEver);
-        ImGui::Begin("Cube");
+        // Per-frame uniforms shared by every shader
+        UniformBuffer frameUniforms(sizeof(FrameUniforms), FRAME_UNIFORMS_BINDING);
+        AntiAliasing antiAliasing;
+
+        // Create the cubes and bind them to the window (so we can directly update them using keyboard interrupts)
+        // The cubes live on the simulation thread, this one only draws their snapshots.
+        // What onTick uses is declared first, so it outlives the thread ~Simulation joins
+        GridAnimation gridAnimation(seed);
+        Simulation simulation;
+        if (gridSize > 1) simulation.scene.addGrid(gridSize, gridSize, 1.0f, GRID_SPACING, seed, layers);
+        else              simulation.scene.add(1.0f, seed, glm::vec3(0.0f), layers);
+        for (int i = 0; i < simulation.scene.size(); i++)
+            simulation.scene.cube(i).maxTurnsPerSecond = maxTurnsPerSecond;
+        if (replayPath)
         {
-            gameEvents();
-
-            glBindFramebuffer(GL_FRAMEBUFFER, gameWindow.FBO);
-            glViewport(0, 0, gameWindow.width, gameWindow.height);
-            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-            // Cube logic
-            cube.perFrame(dt);
-            cube.render(camera.projectionView);
-
-            glBindFramebuffer(GL_FRAMEBUFFER, 0);
-
-            // Reset the viewport for the default framebuffer
-            int display_w, display_h;
-            glfwGetFramebufferSize(window, &display_w, &display_h);
-            glViewport(0, 0, display_w, display_h);
-            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-            
-            // Display FBO texture to ImGui window
-            ImGui::Image((ImTextureID)(intptr_t)gameWindow.texture, ImVec2(gameWindow.width, gameWindow.height), ImVec2(0, 1), ImVec2(1, 0));
+            replay.start(simulation.scene);
+            simulation.onTick = [&replay](CubeScene &scene, double dt) { replay.update(scene, dt); };
         }
-        ImGui::End();
-
-        // Render
-        ImGui::Render();
-        ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
-
-        ImGuiIO& io = ImGui::GetIO();
-        if (io.ConfigFlags & ImGuiConfigFlags_ViewportsEnable)
+        else if (gridSize > 1)
+            simulation.onTick = [&gridAnimation](CubeScene &scene, double dt) { gridAnimation.update(scene, dt); };
+        glfwSetWindowUserPointer(window, &simulation);
+        simulation.start();
+
+        // Back stickers only show through the gaps, which are barely there on big cubes
+        StickerRenderer stickerRenderer;
+        SceneRenderer sceneRenderer(&stickerRenderer);
+        sceneRenderer.hideBackStickers = gridSize > 1 || layers > 3;
+
+        // Create GUI instance
+        cubeGUI = GUI(&camera);
+        int timelinePosition = 0;
+
+        Profiler profiler;
+        float t = 0.0f;
+        glm::ivec2 lastFBOSize((int)gameWindow.width, (int)gameWindow.height);
+        int settleFrames = 0;
+        while (!glfwWindowShouldClose(window))
         {
-            GLFWwindow* backup_current_context = glfwGetCurrentContext();
-            ImGui::UpdatePlatformWindows();
-            ImGui::RenderPlatformWindowsDefault();
-            glfwMakeContextCurrent(backup_current_context);
+            // Once the cube is at rest and ImGui has settled, sleep until input arrives. Only
+            // a wake-up by an event needs a new frame, the previous one is still on screen
+            // The grid keeps turning on its own, so it never idles. New snapshots wake us too
+            const SceneSnapshot *snapshot = &simulation.latestSnapshot();
+            bool idle = settleFrames >= GUI_SETTLE_FRAMES && gridSize == 1 && !sceneRenderer.needsRedraw(*snapshot) && !camera.dirty;
+            if (idle)
+            {
+                double waitStart = glfwGetTime();
+                glfwWaitEventsTimeout(IDLE_WAIT_TIMEOUT);
+                if (glfwGetTime() - waitStart >= IDLE_WAIT_TIMEOUT) continue;
+                settleFrames = 0;
+                snapshot = &simulation.latestSnapshot();
+            }
+
+            // Time spent asleep is left out, a frame starts once there is something to draw
+            profiler.beginFrame();
+            if (!idle)
+            {
+                ProfileScope scope(profiler, "Poll events");
+                glfwPollEvents();
+                settleFrames++;
+            }
+
+            // Start the Dear ImGui frame
+            {
+                ProfileScope scope(profiler, "ImGui new frame");
+                ImGui_ImplOpenGL3_NewFrame();
+                ImGui_ImplGlfw_NewFrame();
+                ImGui::NewFrame();
+                ImGui::DockSpaceOverViewport(0, ImGui::GetMainViewport());
+            }
+
+            // cubeGUI.show();
+            bool settingsChanged = cubeGUI.profiler(profiler, sceneRenderer.getUploads(), antiAliasing);
+            if (timeline.size() > 0 && cubeGUI.timeline(timeline.size(), timelinePosition))
+            {
+                int target = timelinePosition;
+                simulation.post([&timeline, target](CubeScene &scene) { timeline.playTo(scene, target); });
+            }
+
+            // The simulation's time this frame shows, the GPU gets it from the snapshot's epoch
+            double currentFrame = Simulation::renderTime();
+
+            // Get the size of the ImGui window
+            ImGui::SetNextWindowDockID(ImGui::GetID("DockSpace"), ImGuiCond_FirstUseEver);
+            ImGui::Begin("Cube");
+            {
+                bool resized = gameEvents(currentFrame);
+
+                // The FBO texture is reused while nothing in it changes
+                if (resized || settingsChanged || camera.dirty || sceneRenderer.needsRedraw(*snapshot))
+                {
+                    // One scope per mode, so the cost of each stays on show after switching
+                    static const char *renderScopes[AntiAliasing::NUM_MODES] = {
+                        "Cube render (no AA)", "Cube render (MSAA 2x)", "Cube render (MSAA 4x)",
+                        "Cube render (MSAA 8x)", "Cube render (FXAA)"
+                    };
+                    ProfileScope scope(profiler, renderScopes[antiAliasing.mode], true);
+                    glBindFramebuffer(GL_FRAMEBUFFER, antiAliasing.begin(gameWindow));
+                    glViewport(0, 0, gameWindow.width, gameWindow.height);
+                    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+                    FrameUniforms frame = { camera.projectionView, camera.position, (float)(currentFrame - snapshot->epoch) };
+                    frameUniforms.update(&frame);
+                    sceneRenderer.render(*snapshot, camera, currentFrame);
+                    antiAliasing.resolve(gameWindow);
+                    camera.dirty = false;
+
+                    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+                }
+
+                // Reset the viewport for the default framebuffer
+                int display_w, display_h;
+                glfwGetFramebufferSize(window, &display_w, &display_h);
+                glViewport(0, 0, display_w, display_h);
+                glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+            
+                // Display FBO texture to ImGui window, only the part the cube was drawn into
+                glm::vec2 uv = gameWindow.uvScale();
+                ImGui::Image((ImTextureID)(intptr_t)gameWindow.texture, ImVec2(gameWindow.width, gameWindow.height), ImVec2(0, uv.y), ImVec2(uv.x, 0));
+            }
+            ImGui::End();
+
+            // Render
+            {
+                ProfileScope scope(profiler, "ImGui render", true);
+                ImGui::Render();
+                ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+            }
+
+            ImGuiIO& io = ImGui::GetIO();
+            if (io.ConfigFlags & ImGuiConfigFlags_ViewportsEnable)
+            {
+                ProfileScope scope(profiler, "Viewports");
+                GLFWwindow* backup_current_context = glfwGetCurrentContext();
+                ImGui::UpdatePlatformWindows();
+                ImGui::RenderPlatformWindowsDefault();
+                glfwMakeContextCurrent(backup_current_context);
+            }
+
+            {
+                ProfileScope scope(profiler, "Swap buffers");
+                glfwSwapBuffers(window);
+            }
+            profiler.endFrame();
         }
-
-        glfwSwapBuffers(window);
     }
 
     // Clean up
+    gameWindow = Window();
     glfwTerminate();
 
     return 0;
@@ -198,3 +393,196 @@ void initImGui(GLFWwindow *window)
     ImGui_ImplGlfw_InitForOpenGL(window, true);
     ImGui_ImplOpenGL3_Init("#version 330");
 }
+
+bool readFile(const char *path, std::string &contents)
+{
+    FILE *file = fopen(path, "rb");
+    if (file == NULL)
+    {
+        fprintf(stderr, "Error: Failed to open %s\n", path);
+        return false;
+    }
+    char buffer[1 << 16];
+    size_t read;
+    while ((read = fread(buffer, 1, sizeof(buffer), file)) > 0) contents.append(buffer, read);
+    fclose(file);
+    return true;
+}
+
+// --scrambles N [--seed S] [--threads T] [--length L] [--random-state] [--out FILE]
+int generateScrambles(int argc, char **argv)
+{
+    ScrambleGenerator generator;
+    generator.threads = std::thread::hardware_concurrency();
+    uint64_t count = argc > 2 ? strtoull(argv[2], NULL, 10) : 0;
+    const char *outPath = NULL;
+
+    for (int i = 3; i < argc; i++)
+    {
+        bool hasValue = i + 1 < argc;
+        if      (strcmp(argv[i], "--seed") == 0 && hasValue)    generator.seed = strtoull(argv[++i], NULL, 10);
+        else if (strcmp(argv[i], "--threads") == 0 && hasValue) generator.threads = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--length") == 0 && hasValue)  generator.length = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--out") == 0 && hasValue)     outPath = argv[++i];
+        else if (strcmp(argv[i], "--random-state") == 0)        generator.randomState = true;
+        else
+        {
+            fprintf(stderr, "Unknown option %s\n", argv[i]);
+            return 1;
+        }
+    }
+
+    FILE *out = outPath ? fopen(outPath, "w") : stdout;
+    if (out == NULL)
+    {
+        fprintf(stderr, "Error: Failed to open %s\n", outPath);
+        return 1;
+    }
+
+    generator.run(count, out);
+
+    if (outPath) fclose(out);
+    return 0;
+}
+
+// --render FILE --out-dir DIR [--size N], FILE holds one scramble per line, "-" for stdin
+int renderStates(int argc, char **argv)
+{
+    StateRenderer renderer;
+    const char *inPath = argc > 2 ? argv[2] : "-";
+    const char *outDir = ".";
+
+    for (int i = 3; i < argc; i++)
+    {
+        bool hasValue = i + 1 < argc;
+        if      (strcmp(argv[i], "--out-dir") == 0 && hasValue) outDir = argv[++i];
+        else if (strcmp(argv[i], "--size") == 0 && hasValue)    renderer.width = renderer.height = atoi(argv[++i]);
+        else
+        {
+            fprintf(stderr, "Unknown option %s\n", argv[i]);
+            return 1;
+        }
+    }
+
+    FILE *in = strcmp(inPath, "-") == 0 ? stdin : fopen(inPath, "r");
+    if (in == NULL)
+    {
+        fprintf(stderr, "Error: Failed to open %s\n", inPath);
+        return 1;
+    }
+
+    HeadlessContext context;
+    if (!context.create()) return 1;
+
+    int count = renderer.run(in, outDir);
+    printf("Rendered %d states to %s\n", count, outDir);
+
+    if (in != stdin) fclose(in);
+    return 0;
+}
+
+// --nets FILE --out-dir DIR [--svg] [--last-layer] [--sticker PX] [--threads T]
+int renderNets(int argc, char **argv)
+{
+    NetRenderer renderer;
+    renderer.threads = std::thread::hardware_concurrency();
+    const char *inPath = argc > 2 ? argv[2] : "-";
+    const char *outDir = ".";
+
+    for (int i = 3; i < argc; i++)
+    {
+        bool hasValue = i + 1 < argc;
+        if      (strcmp(argv[i], "--out-dir") == 0 && hasValue) outDir = argv[++i];
+        else if (strcmp(argv[i], "--sticker") == 0 && hasValue) renderer.stickerSize = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--threads") == 0 && hasValue) renderer.threads = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--svg") == 0)                 renderer.format = NetRenderer::SVG_FILE;
+        else if (strcmp(argv[i], "--last-layer") == 0)          renderer.view = NetRenderer::LAST_LAYER;
+        else
+        {
+            fprintf(stderr, "Unknown option %s\n", argv[i]);
+            return 1;
+        }
+    }
+
+    if (renderer.stickerSize < renderer.minStickerSize())
+    {
+        fprintf(stderr, "Error: --sticker must be at least %d%s\n", renderer.minStickerSize(),
+                renderer.view == NetRenderer::LAST_LAYER ? " with --last-layer" : "");
+        return 1;
+    }
+
+    FILE *in = strcmp(inPath, "-") == 0 ? stdin : fopen(inPath, "r");
+    if (in == NULL)
+    {
+        fprintf(stderr, "Error: Failed to open %s\n", inPath);
+        return 1;
+    }
+
+    int count = renderer.run(in, outDir);
+    printf("Rendered %d nets to %s\n", count, outDir);
+
+    if (in != stdin) fclose(in);
+    return 0;
+}
+
+// --pack-replays FILE --out ARCHIVE [--layers N], FILE holds one solve per line as
+// "<scramble> | <move>@<ms> ...", "-" for stdin
+int packReplays(int argc, char **argv)
+{
+    const char *inPath = argc > 2 ? argv[2] : "-";
+    const char *outPath = NULL;
+    int layers = 3;
+
+    for (int i = 3; i < argc; i++)
+    {
+        bool hasValue = i + 1 < argc;
+        if      (strcmp(argv[i], "--out") == 0 && hasValue)    outPath = argv[++i];
+        else if (strcmp(argv[i], "--layers") == 0 && hasValue) layers = glm::max(atoi(argv[++i]), 1);
+        else
+        {
+            fprintf(stderr, "Unknown option %s\n", argv[i]);
+            return 1;
+        }
+    }
+    if (outPath == NULL)
+    {
+        fprintf(stderr, "Error: --pack-replays needs --out\n");
+        return 1;
+    }
+    if (layers > REPLAY_MAX_CUBE_SIZE)
+    {
+        fprintf(stderr, "Error: --layers must be at most %d\n", REPLAY_MAX_CUBE_SIZE);
+        return 1;
+    }
+
+    FILE *in = strcmp(inPath, "-") == 0 ? stdin : fopen(inPath, "r");
+    if (in == NULL)
+    {
+        fprintf(stderr, "Error: Failed to open %s\n", inPath);
+        return 1;
+    }
+
+    ReplayWriter writer;
+    if (!writer.open(outPath)) return 1;
+    std::string line;
+    int count = 0, lineNumber = 0;
+    char chunk[4096];
+    while (fgets(chunk, sizeof(chunk), in))
+    {
+        line += chunk;
+        if (line.back() != '\n' && !feof(in)) continue;
+        line.erase(line.find_last_not_of("\r\n") + 1);
+        lineNumber++;
+        if (!line.empty())
+        {
+            if (writer.addSolve(line.c_str(), layers)) count++;
+            else fprintf(stderr, "Skipping line %d\n", lineNumber);
+        }
+        line.clear();
+    }
+    if (in != stdin) fclose(in);
+
+    if (!writer.finish()) return 1;
+    printf("Packed %d solves into %s\n", count, outPath);
+    return 0;
+}
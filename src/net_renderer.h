@@ -0,0 +1,207 @@
+#ifndef NET_RENDERER_H
+#define NET_RENDERER_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <algorithm>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+#include "colour_scheme.h"
+#include "cubie.h"
+#include "png.h"
+
+#define NET_RENDERER_MAX_LINE 1024
+
+// Smallest sticker sizes. The last layer's side strips are a quarter sticker thick, and
+// need three pixels to show their colour inside a one pixel border
+#define NET_RENDERER_MIN_STICKER 4
+#define NET_RENDERER_MIN_LAST_LAYER_STICKER 12
+
+/** Pure CPU renderer for 2D diagrams of cube states: the unfolded net, or a top-down
+  * view of the last layer with the side stickers of the top layer around it. Writes
+  * one SVG or PNG per line of a scramble list, using the 3D cube's colours. Worker
+  * threads pull lines off a shared counter, each with its own pixel buffer. */
+class NetRenderer
+{
+public:
+
+    enum View { NET, LAST_LAYER };
+    enum Format { SVG_FILE, PNG_FILE };
+
+    View view = NET;
+    Format format = PNG_FILE;
+    int stickerSize = 16;  // Pixels per sticker, border included
+    int threads = 1;
+
+    // Smallest stickerSize the view keeps every cell's colour at
+    int minStickerSize() const
+    {
+        return view == LAST_LAYER ? NET_RENDERER_MIN_LAST_LAYER_STICKER : NET_RENDERER_MIN_STICKER;
+    }
+
+    // Returns the number of images written
+    int run(FILE *scrambles, const char *outDir)
+    {
+        std::vector<std::string> lines;
+        char line[NET_RENDERER_MAX_LINE];
+        while (fgets(line, sizeof(line), scrambles))
+        {
+            line[strcspn(line, "\r\n")] = '\0';
+            lines.push_back(line);
+        }
+
+        layout();
+        std::atomic<size_t> next(0);
+        std::atomic<int> written(0);
+        std::vector<std::thread> workers;
+        for (int t = 0; t < (threads < 1 ? 1 : threads); t++)
+            workers.emplace_back(&NetRenderer::work, this, &lines, outDir, &next, &written);
+        for (std::thread &worker : workers) worker.join();
+        return written;
+    }
+
+private:
+
+    // One sticker of the diagram, in pixels
+    struct Cell { int x, y, width, height, facelet; };
+
+    std::vector<Cell> cells;
+    int width, height;
+
+    // Images are rastered to palette indices: transparent, black, then every colour
+    enum { TRANSPARENT, BLACK, FIRST_COLOUR, NUM_PALETTE = FIRST_COLOUR + NUM_COLOURS };
+    uint8_t palette[NUM_PALETTE][4];
+
+    void work(const std::vector<std::string> *lines, const char *outDir, std::atomic<size_t> *next, std::atomic<int> *written)
+    {
+        std::vector<uint8_t> pixels((size_t)width * height);
+        std::string text;
+        char path[4096];
+        int8_t facelets[NUM_FACELETS];
+
+        for (size_t i = (*next)++; i < lines->size(); i = (*next)++)
+        {
+            CubieCube state;
+            if (!state.applySequence((*lines)[i].c_str()))
+            {
+                fprintf(stderr, "Skipping line %zu, unknown move in \"%s\"\n", i + 1, (*lines)[i].c_str());
+                continue;
+            }
+            state.facelets(facelets);
+
+            bool ok;
+            if (format == SVG_FILE)
+            {
+                snprintf(path, sizeof(path), "%s/%06zu.svg", outDir, i);
+                svg(facelets, text);
+                FILE *file = fopen(path, "w");
+                ok = file && fwrite(text.data(), 1, text.size(), file) == text.size();
+                if (file) fclose(file);
+                if (!ok) fprintf(stderr, "Error: Failed to write %s\n", path);
+            }
+            else
+            {
+                snprintf(path, sizeof(path), "%s/%06zu.png", outDir, i);
+                raster(facelets, pixels.data());
+                ok = PNG::writeIndexed(path, pixels.data(), width, height, palette, NUM_PALETTE);
+            }
+            if (ok) (*written)++;
+        }
+    }
+
+    /** Cell positions for the current view. Everything is laid out on a grid of quarter
+      * stickers, so the last layer's side strips are a quarter sticker thick. */
+    void layout()
+    {
+        memset(palette, 0, sizeof(palette));
+        palette[BLACK][3] = 255;
+        for (int c = 0; c < NUM_COLOURS; c++)
+        {
+            for (int k = 0; k < 3; k++) palette[FIRST_COLOUR + c][k] = (uint8_t)(255 * colourScheme[c][k]);
+            palette[FIRST_COLOUR + c][3] = 255;
+        }
+
+        cells.clear();
+        auto add = [&](int x, int y, int w, int h, int facelet) {
+            cells.push_back({ x * stickerSize / 4, y * stickerSize / 4,
+                              (x + w) * stickerSize / 4 - x * stickerSize / 4,
+                              (y + h) * stickerSize / 4 - y * stickerSize / 4, facelet });
+        };
+
+        if (view == NET)
+        {
+            // Face origins in stickers, in U R F D L B order
+            static const int origin[6][2] = { { 3, 0 }, { 6, 3 }, { 3, 3 }, { 3, 6 }, { 0, 3 }, { 9, 3 } };
+            for (int f = 0; f < 6; f++)
+                for (int i = 0; i < 9; i++)
+                    add(4 * (origin[f][0] + i % 3), 4 * (origin[f][1] + i / 3), 4, 4, 9*f + i);
+            width = 12 * stickerSize;
+            height = 9 * stickerSize;
+        }
+        else
+        {
+            // U face in the middle, then the top row of B, R, F and L as seen from above
+            for (int i = 0; i < 9; i++) add(1 + 4 * (i % 3), 1 + 4 * (i / 3), 4, 4, i);
+            for (int i = 0; i < 3; i++)
+            {
+                add(1 + 4 * i, 0, 4, 1, 45 + 2 - i);   // B3 B2 B1
+                add(13, 1 + 4 * i, 1, 4, 9 + 2 - i);   // R3 R2 R1
+                add(1 + 4 * i, 13, 4, 1, 18 + i);      // F1 F2 F3
+                add(0, 1 + 4 * i, 1, 4, 36 + i);       // L1 L2 L3
+            }
+            width = height = 14 * stickerSize / 4;
+        }
+    }
+
+    // Black cells with the sticker colour inset by the border, transparent elsewhere.
+    // Cells below minStickerSize are too thin for any colour and stay black
+    void raster(const int8_t *facelets, uint8_t *pixels) const
+    {
+        memset(pixels, TRANSPARENT, (size_t)width * height);
+        int border = stickerSize / 16 > 0 ? stickerSize / 16 : 1;
+        for (const Cell &cell : cells)
+        {
+            uint8_t colour = FIRST_COLOUR + faceColours[facelets[cell.facelet]];
+            int insetWidth = std::max(0, cell.width - 2 * border);
+            int insetHeight = std::max(0, cell.height - 2 * border);
+            for (int y = cell.y; y < cell.y + cell.height; y++)
+            {
+                uint8_t *row = pixels + (size_t)y * width + cell.x;
+                if (insetWidth == 0 || insetHeight == 0 || y < cell.y + border || y >= cell.y + cell.height - border)
+                {
+                    memset(row, BLACK, cell.width);
+                    continue;
+                }
+                memset(row, BLACK, border);
+                memset(row + border, colour, insetWidth);
+                memset(row + cell.width - border, BLACK, border);
+            }
+        }
+    }
+
+    void svg(const int8_t *facelets, std::string &text) const
+    {
+        char buffer[256];
+        snprintf(buffer, sizeof(buffer), "<svg xmlns=\"http://www.w3.org/2000/svg\" width=\"%d\" height=\"%d\" viewBox=\"0 0 %d %d\">\n",
+                 width, height, width, height);
+        text = buffer;
+
+        float border = stickerSize / 16 > 0 ? stickerSize / 16 : 1;
+        for (const Cell &cell : cells)
+        {
+            const float *rgb = colourScheme[faceColours[facelets[cell.facelet]]];
+            snprintf(buffer, sizeof(buffer),
+                     "<rect x=\"%g\" y=\"%g\" width=\"%g\" height=\"%g\" fill=\"#%02x%02x%02x\" stroke=\"#000\" stroke-width=\"%g\"/>\n",
+                     cell.x + border / 2, cell.y + border / 2, std::max(0.0f, cell.width - border), std::max(0.0f, cell.height - border),
+                     (int)(255 * rgb[0]), (int)(255 * rgb[1]), (int)(255 * rgb[2]), border);
+            text += buffer;
+        }
+        text += "</svg>\n";
+    }
+
+};
+
+#endif
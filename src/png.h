@@ -0,0 +1,118 @@
+#ifndef PNG_H
+#define PNG_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <vector>
+#include <zlib.h>
+
+/** Minimal PNG encoder for 8-bit RGBA or palette images: no interlacing and no row
+  * filters, the pixel data goes through zlib as one IDAT chunk. */
+class PNG
+{
+public:
+
+    // GL reads rows bottom-up, flipRows writes them top-down
+    static bool write(const char *path, const uint8_t *rgba, int width, int height, bool flipRows, int level = Z_BEST_SPEED)
+    {
+        return encode(path, rgba, width, height, 4, flipRows, NULL, 0, level);
+    }
+
+    // One byte per pixel indexing an RGBA palette of up to 256 entries
+    static bool writeIndexed(const char *path, const uint8_t *indices, int width, int height,
+                             const uint8_t (*palette)[4], int paletteSize, int level = Z_BEST_SPEED)
+    {
+        return encode(path, indices, width, height, 1, false, palette, paletteSize, level);
+    }
+
+private:
+
+    static bool encode(const char *path, const uint8_t *pixels, int width, int height, int channels, bool flipRows,
+                       const uint8_t (*palette)[4], int paletteSize, int level)
+    {
+        // Every row is prefixed with its filter type, 0 for none
+        size_t stride = (size_t)width * channels;
+        std::vector<uint8_t> raw((stride + 1) * height);
+        for (int y = 0; y < height; y++)
+        {
+            const uint8_t *row = pixels + stride * (flipRows ? height - 1 - y : y);
+            raw[(stride + 1) * y] = 0;
+            memcpy(&raw[(stride + 1) * y + 1], row, stride);
+        }
+
+        uLongf compressedSize = compressBound(raw.size());
+        std::vector<uint8_t> compressed(compressedSize);
+        if (compress2(compressed.data(), &compressedSize, raw.data(), raw.size(), level) != Z_OK)
+        {
+            fprintf(stderr, "Error: Failed to compress %s\n", path);
+            return false;
+        }
+
+        FILE *file = fopen(path, "wb");
+        if (file == NULL)
+        {
+            fprintf(stderr, "Error: Failed to open %s\n", path);
+            return false;
+        }
+
+        static const uint8_t signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+        fwrite(signature, 1, sizeof(signature), file);
+
+        uint8_t header[13];
+        putBigEndian(header, width);
+        putBigEndian(header + 4, height);
+        header[8] = 8;                   // Bit depth
+        header[9] = palette ? 3 : 6;     // Colour type, palette or RGBA
+        header[10] = 0;                  // Deflate
+        header[11] = 0;                  // Adaptive filtering, every row uses none
+        header[12] = 0;                  // No interlacing
+        writeChunk(file, "IHDR", header, sizeof(header));
+
+        // Palette colours, then their alpha values
+        if (palette)
+        {
+            uint8_t colours[256 * 3], alphas[256];
+            for (int i = 0; i < paletteSize; i++)
+            {
+                memcpy(colours + 3*i, palette[i], 3);
+                alphas[i] = palette[i][3];
+            }
+            writeChunk(file, "PLTE", colours, 3 * paletteSize);
+            writeChunk(file, "tRNS", alphas, paletteSize);
+        }
+
+        writeChunk(file, "IDAT", compressed.data(), compressedSize);
+        writeChunk(file, "IEND", NULL, 0);
+
+        bool ok = ferror(file) == 0;
+        fclose(file);
+        return ok;
+    }
+
+    static void putBigEndian(uint8_t *out, uint32_t value)
+    {
+        out[0] = value >> 24;
+        out[1] = value >> 16;
+        out[2] = value >> 8;
+        out[3] = value;
+    }
+
+    // Length, type, data, then the CRC of type and data
+    static void writeChunk(FILE *file, const char *type, const uint8_t *data, uint32_t length)
+    {
+        uint8_t word[4];
+        putBigEndian(word, length);
+        fwrite(word, 1, 4, file);
+        fwrite(type, 1, 4, file);
+        if (length > 0) fwrite(data, 1, length, file);
+
+        uLong crc = crc32(0, (const Bytef*)type, 4);
+        if (length > 0) crc = crc32(crc, data, length);
+        putBigEndian(word, crc);
+        fwrite(word, 1, 4, file);
+    }
+
+};
+
+#endif
@@ -0,0 +1,196 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <vector>
+#include <GL/glew.h>
+
+#define PROFILER_HISTORY 240
+#define PROFILER_QUERY_BUFFERS 2
+
+/** Frame profiler. Scopes are timed on the CPU and, when asked for, on the GPU with a
+  * GL_TIME_ELAPSED query. Queries are double-buffered: a frame's results are read two
+  * frames later, and only if GL_QUERY_RESULT_AVAILABLE says so, so reading never stalls.
+  * A result still pending by then is dropped. GPU scopes can't nest, a GPU scope opened
+  * inside another one is timed on the CPU only.
+  *
+  * Each scope keeps its last PROFILER_HISTORY frames, -1 for frames it didn't run in. */
+class Profiler
+{
+public:
+
+    struct Scope
+    {
+        const char *name;
+        bool gpu;
+        float cpuMs[PROFILER_HISTORY];
+        float gpuMs[PROFILER_HISTORY];
+
+        GLuint queries[PROFILER_QUERY_BUFFERS];
+        long long queryFrame[PROFILER_QUERY_BUFFERS];  // Frame whose result is pending, -1 for none
+        std::chrono::steady_clock::time_point start;
+        bool timingGPU;
+    };
+
+    // Scope 0 is the whole frame, from beginFrame to endFrame
+    std::vector<Scope> scopes;
+
+    Profiler()
+    {
+        scopeIndex("Frame", false);
+    }
+
+    ~Profiler()
+    {
+        for (Scope &scope : scopes)
+            if (scope.gpu) glDeleteQueries(PROFILER_QUERY_BUFFERS, scope.queries);
+    }
+
+    Profiler(const Profiler &) = delete;
+    Profiler &operator=(const Profiler &) = delete;
+
+    // History slot of the current frame, the oldest frame is in the next one
+    int slot() const
+    {
+        return frame % PROFILER_HISTORY;
+    }
+
+    // Starts a new frame and collects the GPU times that arrived meanwhile
+    void beginFrame()
+    {
+        frame++;
+        for (Scope &scope : scopes)
+        {
+            scope.cpuMs[slot()] = scope.gpuMs[slot()] = -1.0f;
+            if (scope.gpu) collect(scope);
+        }
+        stack.clear();
+        gpuOpen = false;
+        scopes[0].start = std::chrono::steady_clock::now();
+    }
+
+    void endFrame()
+    {
+        scopes[0].cpuMs[slot()] = milliseconds(scopes[0].start, std::chrono::steady_clock::now());
+    }
+
+    void begin(const char *name, bool gpu = false)
+    {
+        int i = scopeIndex(name, gpu);
+        Scope &scope = scopes[i];
+        stack.push_back(i);
+
+        scope.timingGPU = scope.gpu && !gpuOpen;
+        if (scope.timingGPU)
+        {
+            int q = frame % PROFILER_QUERY_BUFFERS;
+            glBeginQuery(GL_TIME_ELAPSED, scope.queries[q]);
+            scope.queryFrame[q] = frame;
+            gpuOpen = true;
+        }
+        scope.start = std::chrono::steady_clock::now();
+    }
+
+    void end()
+    {
+        if (stack.empty()) return;
+        Scope &scope = scopes[stack.back()];
+        stack.pop_back();
+
+        // A scope entered more than once a frame adds up
+        float ms = milliseconds(scope.start, std::chrono::steady_clock::now());
+        float &sample = scope.cpuMs[slot()];
+        sample = sample < 0.0f ? ms : sample + ms;
+
+        if (scope.timingGPU)
+        {
+            glEndQuery(GL_TIME_ELAPSED);
+            gpuOpen = false;
+        }
+    }
+
+    // The q quantile (0 to 1) of the frames kept, ignoring frames without a sample
+    static float percentile(const float *samples, float q)
+    {
+        float sorted[PROFILER_HISTORY];
+        int count = 0;
+        for (int i = 0; i < PROFILER_HISTORY; i++)
+            if (samples[i] >= 0.0f) sorted[count++] = samples[i];
+        if (count == 0) return 0.0f;
+
+        int k = (int)(q * (count - 1) + 0.5f);
+        std::nth_element(sorted, sorted + k, sorted + count);
+        return sorted[k];
+    }
+
+private:
+
+    long long frame = -1;
+    std::vector<int> stack;
+    bool gpuOpen = false;
+
+    static float milliseconds(std::chrono::steady_clock::time_point from, std::chrono::steady_clock::time_point to)
+    {
+        return std::chrono::duration<float, std::milli>(to - from).count();
+    }
+
+    int scopeIndex(const char *name, bool gpu)
+    {
+        for (size_t i = 0; i < scopes.size(); i++)
+            if (scopes[i].name == name || strcmp(scopes[i].name, name) == 0) return i;
+
+        scopes.emplace_back();
+        Scope &scope = scopes.back();
+        scope.name = name;
+        scope.gpu = gpu;
+        std::fill(scope.cpuMs, scope.cpuMs + PROFILER_HISTORY, -1.0f);
+        std::fill(scope.gpuMs, scope.gpuMs + PROFILER_HISTORY, -1.0f);
+        if (gpu) glGenQueries(PROFILER_QUERY_BUFFERS, scope.queries);
+        for (int q = 0; q < PROFILER_QUERY_BUFFERS; q++) scope.queryFrame[q] = -1;
+        return scopes.size() - 1;
+    }
+
+    // Reads the result of the query this frame is about to reuse, if the GPU has it
+    void collect(Scope &scope)
+    {
+        int q = frame % PROFILER_QUERY_BUFFERS;
+        if (scope.queryFrame[q] < 0) return;
+
+        GLint available = 0;
+        glGetQueryObjectiv(scope.queries[q], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (available && frame - scope.queryFrame[q] < PROFILER_HISTORY)
+        {
+            GLuint64 nanoseconds = 0;
+            glGetQueryObjectui64v(scope.queries[q], GL_QUERY_RESULT, &nanoseconds);
+            scope.gpuMs[scope.queryFrame[q] % PROFILER_HISTORY] = nanoseconds / 1.0e6f;
+        }
+        scope.queryFrame[q] = -1;
+    }
+
+};
+
+// Times the enclosing block
+class ProfileScope
+{
+public:
+
+    ProfileScope(Profiler &profiler, const char *name, bool gpu = false)
+        : profiler(profiler)
+    {
+        profiler.begin(name, gpu);
+    }
+
+    ~ProfileScope()
+    {
+        profiler.end();
+    }
+
+private:
+
+    Profiler &profiler;
+
+};
+
+#endif
@@ -0,0 +1,91 @@
+#ifndef RANDOM_H
+#define RANDOM_H
+
+#include <stdint.h>
+
+/** xoshiro256** by Blackman and Vigna. Small, fast and splittable: jump() advances the
+  * state by 2^128 steps, so streams taken one jump apart never overlap. Not thread
+  * safe; give every thread its own stream. */
+class Random
+{
+public:
+
+    Random(uint64_t seed = 0)
+    {
+        // Expand the seed with splitmix64 so similar seeds give unrelated streams
+        for (int i = 0; i < 4; i++)
+        {
+            seed += 0x9E3779B97F4A7C15ULL;
+            uint64_t z = seed;
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+            s[i] = z ^ (z >> 31);
+        }
+    }
+
+    uint64_t next()
+    {
+        const uint64_t result = rotl(s[1] * 5, 7) * 9;
+        const uint64_t t = s[1] << 17;
+
+        s[2] ^= s[0];
+        s[3] ^= s[1];
+        s[1] ^= s[2];
+        s[0] ^= s[3];
+        s[2] ^= t;
+        s[3] = rotl(s[3], 45);
+
+        return result;
+    }
+
+    // Unbiased integer in [0, n), Lemire's multiply-and-reject method
+    uint32_t below(uint32_t n)
+    {
+        uint64_t m = (next() >> 32) * n;
+        uint32_t low = (uint32_t)m;
+        if (low < n)
+        {
+            uint32_t threshold = -n % n;
+            while (low < threshold)
+            {
+                m = (next() >> 32) * n;
+                low = (uint32_t)m;
+            }
+        }
+        return m >> 32;
+    }
+
+    void jump()
+    {
+        static const uint64_t JUMP[] = { 0x180EC6D33CFD0ABAULL, 0xD5A61266F0C9392CULL, 0xA9582618E03FC9AAULL, 0x39ABDC4529B1661CULL };
+
+        uint64_t t[4] = { 0, 0, 0, 0 };
+        for (int i = 0; i < 4; i++)
+        {
+            for (int b = 0; b < 64; b++)
+            {
+                if (JUMP[i] & (1ULL << b))
+                {
+                    t[0] ^= s[0];
+                    t[1] ^= s[1];
+                    t[2] ^= s[2];
+                    t[3] ^= s[3];
+                }
+                next();
+            }
+        }
+        for (int i = 0; i < 4; i++) s[i] = t[i];
+    }
+
+private:
+
+    uint64_t s[4];
+
+    static uint64_t rotl(const uint64_t x, int k)
+    {
+        return (x << k) | (x >> (64 - k));
+    }
+
+};
+
+#endif
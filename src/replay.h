@@ -0,0 +1,579 @@
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include <ctype.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <string>
+#include <vector>
+#include "cube_scene.h"
+#include "facelet_cube.h"
+
+#define REPLAY_MAGIC "CRPL"
+#define REPLAY_VERSION 1
+#define REPLAY_HEADER_SIZE 32
+
+// Largest cube size a solve can hold, readers reject anything bigger
+#define REPLAY_MAX_CUBE_SIZE 255
+
+/** Replay archives hold any number of recorded solves:
+  *
+  *     header    "CRPL", u32 version, u64 solve count, u64 index offset, u64 reserved
+  *     solves    varint cube size N, the scramble state packed as by FaceletCube::pack,
+  *               varint move count M, then three streams:
+  *                   codes     M bytes, one per move
+  *                   layers    varint byte count, then first and last layer as varints
+  *                             for every move whose layers have no code
+  *                   times     the milliseconds since the move before (since the start
+  *                             for the first) as group varints
+  *     index     u64 offset of every solve
+  *
+  * Integers are little endian, varints LEB128. A code byte holds the quarter turns in
+  * bits 6-7, the axis in bits 4-5 and the layers in bits 0-3: codes 0-14 name the 15
+  * blocks of layers [first, last] with last < 5, code 15 takes them from the layers
+  * stream. Group varints come four to a control byte whose bit pairs, low first, hold
+  * the byte length of each time less one, so a move of a cube up to 5x5 takes a byte
+  * and its time a bit over one or two more.
+  *
+  * Keeping the streams apart leaves one dependent load per four moves, where a varint
+  * after every code byte would make each move wait for the length of the one before:
+  * decoding runs at memory speed rather than load latency. */
+
+// Layer blocks [first, last] of the 15 one-byte layer codes
+static const uint8_t replaySpanFirst[15] = { 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 3, 3, 4 };
+static const uint8_t replaySpanLast[15]  = { 0, 1, 2, 3, 4, 1, 2, 3, 4, 2, 3, 4, 3, 4, 4 };
+
+/** Writes a replay archive. Solves are written as they are added, only the index is
+  * kept in memory. */
+class ReplayWriter
+{
+public:
+
+    ~ReplayWriter()
+    {
+        if (file) finish();
+    }
+
+    bool open(const char *path)
+    {
+        file = fopen(path, "wb");
+        if (file == NULL)
+        {
+            fprintf(stderr, "Error: Failed to open %s\n", path);
+            return false;
+        }
+        uint8_t header[REPLAY_HEADER_SIZE] = { 0 };
+        fwrite(header, 1, sizeof(header), file);
+        offset = REPLAY_HEADER_SIZE;
+        return true;
+    }
+
+    /** Moves are the solve's moves, timesMs when each was made since the solve started.
+      * Returns false, adding nothing, for cubes over REPLAY_MAX_CUBE_SIZE. */
+    bool addSolve(const FaceletCube &scramble, const std::vector<LayerMove> &moves, const std::vector<uint32_t> &timesMs)
+    {
+        if (scramble.getSize() > REPLAY_MAX_CUBE_SIZE)
+        {
+            fprintf(stderr, "Replay: cube size %d is over %d\n", scramble.getSize(), REPLAY_MAX_CUBE_SIZE);
+            return false;
+        }
+        index.push_back(offset);
+        bytes.clear();
+        layers.clear();
+        putVarint(bytes, scramble.getSize());
+        size_t packed = bytes.size();
+        bytes.resize(packed + scramble.packedSize());
+        scramble.pack(bytes.data() + packed);
+        putVarint(bytes, moves.size());
+
+        for (const LayerMove &move : moves)
+        {
+            int span = 15;
+            for (int s = 0; s < 15; s++)
+                if (replaySpanFirst[s] == move.firstLayer && replaySpanLast[s] == move.lastLayer) span = s;
+            bytes.push_back(move.quarterTurns << 6 | move.axis << 4 | span);
+            if (span == 15)
+            {
+                putVarint(layers, move.firstLayer);
+                putVarint(layers, move.lastLayer);
+            }
+        }
+        putVarint(bytes, layers.size());
+        bytes.insert(bytes.end(), layers.begin(), layers.end());
+
+        uint32_t last = 0;
+        for (size_t group = 0; group < moves.size(); group += 4)
+        {
+            size_t control = bytes.size();
+            bytes.push_back(0);
+            for (size_t i = group; i < group + 4 && i < moves.size(); i++)
+            {
+                uint32_t time = timesMs[i] > last ? timesMs[i] : last;
+                uint32_t delta = time - last;
+                int length = delta < (1 << 8) ? 1 : delta < (1 << 16) ? 2 : delta < (1 << 24) ? 3 : 4;
+                bytes[control] |= (length - 1) << (2 * (i - group));
+                for (int b = 0; b < length; b++) bytes.push_back(delta >> (8 * b));
+                last = time;
+            }
+        }
+        fwrite(bytes.data(), 1, bytes.size(), file);
+        offset += bytes.size();
+        return true;
+    }
+
+    /** Adds a solve written as text, "<scramble> | <move>@<ms> <move>@<ms> ...": the
+      * scramble from a solved cube of the given size, then every move of the solve with
+      * when it was made. Returns false, adding nothing, on a move it can't parse or a
+      * cube over REPLAY_MAX_CUBE_SIZE. */
+    bool addSolve(const char *line, int cubeSize)
+    {
+        FaceletCube scramble(cubeSize);
+        std::vector<LayerMove> moves;
+        std::vector<uint32_t> timesMs;
+        bool solving = false;
+        std::string token;
+        for (const char *c = line; ; c++)
+        {
+            if (*c != '\0' && *c != '|' && !isspace((unsigned char)*c))
+            {
+                token += *c;
+                continue;
+            }
+            if (!token.empty())
+            {
+                LayerMove move;
+                size_t at = token.find('@');
+                if (solving && at != std::string::npos && LayerMove::parse(token.substr(0, at).c_str(), cubeSize, move))
+                {
+                    moves.push_back(move);
+                    timesMs.push_back(strtoul(token.c_str() + at + 1, NULL, 10));
+                }
+                else if (!solving && LayerMove::parse(token.c_str(), cubeSize, move)) scramble.apply(move);
+                else
+                {
+                    fprintf(stderr, "Replay: unknown move \"%s\"\n", token.c_str());
+                    return false;
+                }
+                token.clear();
+            }
+            if (*c == '|') solving = true;
+            if (*c == '\0') break;
+        }
+        return addSolve(scramble, moves, timesMs);
+    }
+
+    // Writes the index and the header, the archive is complete after this
+    bool finish()
+    {
+        for (uint64_t solveOffset : index)
+        {
+            uint8_t le[8];
+            putU64(le, solveOffset);
+            fwrite(le, 1, 8, file);
+        }
+
+        uint8_t header[REPLAY_HEADER_SIZE] = { 0 };
+        memcpy(header, REPLAY_MAGIC, 4);
+        header[4] = REPLAY_VERSION;
+        putU64(header + 8, index.size());
+        putU64(header + 16, offset);
+        fseek(file, 0, SEEK_SET);
+        fwrite(header, 1, sizeof(header), file);
+
+        bool ok = !ferror(file);
+        fclose(file);
+        file = NULL;
+        if (!ok) fprintf(stderr, "Error: Failed to write the replay archive\n");
+        return ok;
+    }
+
+private:
+
+    FILE *file = NULL;
+    uint64_t offset = 0;
+    std::vector<uint64_t> index;
+    std::vector<uint8_t> bytes, layers;
+
+    static void putVarint(std::vector<uint8_t> &out, uint32_t value)
+    {
+        while (value >= 0x80)
+        {
+            out.push_back((value & 0x7F) | 0x80);
+            value >>= 7;
+        }
+        out.push_back(value);
+    }
+
+    static void putU64(uint8_t *out, uint64_t value)
+    {
+        for (int i = 0; i < 8; i++) out[i] = value >> (8 * i);
+    }
+
+};
+
+/** One solve of a mapped archive, pointing into the mapping. Readers load times four
+  * bytes at a time and may read up to 3 bytes past end, which the index following
+  * every solve keeps inside the mapping. */
+struct ReplaySolve
+{
+    int cubeSize;
+    const uint8_t *scramble;   // Packed state
+    uint32_t moveCount;
+    const uint8_t *codes;
+    const uint8_t *layers;     // Layers of the moves coded 15
+    const uint8_t *times;
+    const uint8_t *end;
+
+    void scrambleState(FaceletCube &out) const
+    {
+        if (out.getSize() != cubeSize) out = FaceletCube(cubeSize);
+        out.unpack(scramble);
+    }
+};
+
+/** Decodes the moves of one solve in order, straight from the mapping. Malformed data,
+  * or a move the cube doesn't have, ends the solve early rather than reading past it. */
+class ReplayReader
+{
+public:
+
+    ReplayReader() {}
+
+    ReplayReader(const ReplaySolve &solve)
+        : codes(solve.codes)
+        , layers(solve.layers)
+        , layersEnd(solve.times)
+        , times(solve.times)
+        , end(solve.end)
+        , count(solve.moveCount)
+        , cubeSize(solve.cubeSize)
+    {
+        for (int s = 0; s < 15; s++)
+            if (replaySpanLast[s] < cubeSize) plainSpans |= 1 << s;
+    }
+
+    // The next move and its time since the solve started, false after the last
+    bool next(LayerMove &move, uint32_t &timeMs)
+    {
+        if (i >= count) return false;
+        if ((i & 3) == 0 && !readTimes()) return false;
+
+        uint8_t code = codes[i];
+        move.quarterTurns = code >> 6;
+        move.axis = (code >> 4) & 3;
+        int span = code & 0xF;
+        if (span < 15)
+        {
+            move.firstLayer = replaySpanFirst[span];
+            move.lastLayer = replaySpanLast[span];
+        }
+        else
+        {
+            // A truncated layers stream ends the solve before this move
+            uint32_t first, last;
+            if (!varint(first) || !varint(last)) return false;
+            move.firstLayer = first;
+            move.lastLayer = last;
+        }
+        time += deltas[i & 3];
+        timeMs = time;
+        i++;
+        return move.quarterTurns != 0 && move.axis != 3 && move.firstLayer <= move.lastLayer && move.lastLayer < cubeSize;
+    }
+
+    /** Up to max moves at once, returning how many were read: the way to scan many
+      * solves. Whole groups of four with no move coded 15 are decoded without checks
+      * between their moves. */
+    uint32_t read(LayerMove *moves, uint32_t *timesMs, uint32_t max)
+    {
+        static const uint32_t masks[4] = { 0xFF, 0xFFFF, 0xFFFFFF, 0xFFFFFFFF };
+        uint32_t n = 0;
+        while (n < max)
+        {
+            // The state is kept in locals while in the fast loop
+            const uint8_t *t = times;
+            uint32_t at = i, clock = time;
+            while ((at & 3) == 0 && at + 4 <= count && n + 4 <= max && t < end && t + groupSize(*t) <= end && plain(codes + at))
+            {
+                const uint8_t *c = codes + at;
+                uint8_t control = *t++;
+                for (int k = 0; k < 4; k++)
+                {
+                    int length = (control >> (2 * k) & 3) + 1;
+                    clock += (t[0] | t[1] << 8 | t[2] << 16 | (uint32_t)t[3] << 24) & masks[length - 1];
+                    t += length;
+                    timesMs[n + k] = clock;
+
+                    LayerMove &move = moves[n + k];
+                    move.quarterTurns = c[k] >> 6;
+                    move.axis = c[k] >> 4 & 3;
+                    move.firstLayer = replaySpanFirst[c[k] & 0xF];
+                    move.lastLayer = replaySpanLast[c[k] & 0xF];
+                }
+                at += 4;
+                n += 4;
+            }
+            times = t;
+            i = at;
+            time = clock;
+
+            // One move at a time through the end of the solve, a group with a move coded 15 or a partial one
+            if (n >= max || !next(moves[n], timesMs[n])) break;
+            n++;
+        }
+        return n;
+    }
+
+private:
+
+    const uint8_t *codes = NULL, *layers = NULL, *layersEnd = NULL, *times = NULL, *end = NULL;
+    uint32_t count = 0, i = 0;
+    int cubeSize = 0;
+    uint32_t plainSpans = 0;  // Bit per layer code naming layers the cube has
+    uint32_t time = 0;
+    uint32_t deltas[4];
+
+    // Bytes of a group of times, its control byte included
+    static int groupSize(uint8_t control)
+    {
+        return 5 + (control & 3) + (control >> 2 & 3) + (control >> 4 & 3) + (control >> 6);
+    }
+
+    // Four valid moves with their layers in the codes
+    bool plain(const uint8_t *c) const
+    {
+        for (int k = 0; k < 4; k++)
+            if (!(plainSpans >> (c[k] & 0xF) & 1) || c[k] < 0x40 || (c[k] & 0x30) == 0x30) return false;
+        return true;
+    }
+
+    // The next group of four times. Each is one unaligned load and a mask, so the only
+    // dependency between groups is the control byte's length
+    bool readTimes()
+    {
+        static const uint32_t masks[4] = { 0xFF, 0xFFFF, 0xFFFFFF, 0xFFFFFFFF };
+        if (times >= end)
+        {
+            count = i;
+            return false;
+        }
+        uint8_t control = *times++;
+        for (uint32_t k = 0; k < 4 && i + k < count; k++)
+        {
+            int length = (control >> (2 * k) & 3) + 1;
+            if (end - times >= length)
+                deltas[k] = (times[0] | times[1] << 8 | times[2] << 16 | (uint32_t)times[3] << 24) & masks[length - 1];
+            else
+            {
+                count = i + k;
+                return k > 0;
+            }
+            times += length;
+        }
+        return true;
+    }
+
+    // False, ending the solve at the current move, if the layers stream runs out
+    bool varint(uint32_t &value)
+    {
+        value = 0;
+        for (int shift = 0; shift < 35 && layers < layersEnd; shift += 7)
+        {
+            uint8_t byte = *layers++;
+            value |= (uint32_t)(byte & 0x7F) << shift;
+            if (byte < 0x80) return true;
+        }
+        count = i;
+        return false;
+    }
+
+};
+
+/** A replay archive mapped into memory. Nothing is read up front, pages are only
+  * faulted in as solves are used, so archives of any size open instantly. */
+class ReplayArchive
+{
+public:
+
+    ReplayArchive() {}
+
+    ~ReplayArchive()
+    {
+        close();
+    }
+
+    ReplayArchive(const ReplayArchive &) = delete;
+    ReplayArchive &operator=(const ReplayArchive &) = delete;
+
+    bool open(const char *path)
+    {
+        close();
+        int fd = ::open(path, O_RDONLY);
+        if (fd < 0)
+        {
+            fprintf(stderr, "Error: Failed to open %s\n", path);
+            return false;
+        }
+        struct stat info;
+        if (fstat(fd, &info) == 0 && info.st_size >= REPLAY_HEADER_SIZE)
+        {
+            length = info.st_size;
+            void *mapped = mmap(NULL, length, PROT_READ, MAP_PRIVATE, fd, 0);
+            data = mapped == MAP_FAILED ? NULL : (const uint8_t*)mapped;
+        }
+        ::close(fd);
+
+        if (data == NULL || memcmp(data, REPLAY_MAGIC, 4) != 0 || data[4] != REPLAY_VERSION)
+        {
+            fprintf(stderr, "Error: %s is not a replay archive\n", path);
+            close();
+            return false;
+        }
+        solves = getU64(data + 8);
+        indexOffset = getU64(data + 16);
+        if (indexOffset > length || solves > (length - indexOffset) / 8)
+        {
+            fprintf(stderr, "Error: The index of %s is truncated\n", path);
+            close();
+            return false;
+        }
+        return true;
+    }
+
+    void close()
+    {
+        if (data) munmap((void*)data, length);
+        data = NULL;
+        length = 0;
+        solves = 0;
+    }
+
+    uint64_t size() const
+    {
+        return solves;
+    }
+
+    // False if solve i is out of range or its header runs past the archive
+    bool solve(uint64_t i, ReplaySolve &out) const
+    {
+        if (i >= solves) return false;
+        uint64_t start = getU64(data + indexOffset + 8 * i);
+        uint64_t end = i + 1 < solves ? getU64(data + indexOffset + 8 * (i + 1)) : indexOffset;
+        if (start >= end || end > indexOffset) return false;
+
+        const uint8_t *p = data + start;
+        const uint8_t *limit = data + end;
+        uint32_t size;
+        if (!varint(p, limit, size) || size < 1 || size > REPLAY_MAX_CUBE_SIZE) return false;
+        out.cubeSize = size;
+        out.scramble = p;
+        p += FaceletCube::packedSize(size);
+        uint32_t layerBytes;
+        if (p > limit || !varint(p, limit, out.moveCount) || out.moveCount > (uint64_t)(limit - p)) return false;
+        out.codes = p;
+        p += out.moveCount;
+        if (!varint(p, limit, layerBytes) || layerBytes > (uint64_t)(limit - p)) return false;
+        out.layers = p;
+        out.times = p + layerBytes;
+        out.end = limit;
+        return true;
+    }
+
+private:
+
+    const uint8_t *data = NULL;
+    size_t length = 0;
+    uint64_t solves = 0, indexOffset = 0;
+
+    static uint64_t getU64(const uint8_t *in)
+    {
+        uint64_t value = 0;
+        for (int i = 0; i < 8; i++) value |= (uint64_t)in[i] << (8 * i);
+        return value;
+    }
+
+    static bool varint(const uint8_t *&p, const uint8_t *end, uint32_t &value)
+    {
+        value = 0;
+        for (int shift = 0; shift < 35 && p < end; shift += 7)
+        {
+            uint8_t byte = *p++;
+            value |= (uint32_t)(byte & 0x7F) << shift;
+            if (byte < 0x80) return true;
+        }
+        return false;
+    }
+
+};
+
+/** Streams one solve of an archive into the move queues of a scene in real time: start
+  * shows the scramble, then update queues every move once its time has come. */
+class ReplayPlayer
+{
+public:
+
+    // Playback speed, 2 plays twice as fast as recorded
+    float speed = 1.0f;
+
+    bool load(const ReplayArchive &archive, uint64_t index)
+    {
+        if (!archive.solve(index, solve))
+        {
+            fprintf(stderr, "Error: No solve %llu in the archive\n", (unsigned long long)index);
+            return false;
+        }
+        return true;
+    }
+
+    int cubeSize() const
+    {
+        return solve.cubeSize;
+    }
+
+    // Shows the scramble on every cube of the solve's size and rewinds
+    void start(CubeScene &scene)
+    {
+        FaceletCube scramble;
+        solve.scrambleState(scramble);
+        for (int i = 0; i < scene.size(); i++)
+            if (scene.cube(i).getSize() == solve.cubeSize) scene.cube(i).setState(scramble);
+
+        reader = ReplayReader(solve);
+        clock = 0.0;
+        pending = reader.next(nextMove, nextTime);
+    }
+
+    void update(CubeScene &scene, double dt)
+    {
+        clock += dt * speed;
+        while (pending && nextTime <= clock * 1000.0)
+        {
+            for (int i = 0; i < scene.size(); i++)
+                if (scene.cube(i).getSize() == solve.cubeSize) scene.cube(i).move(nextMove);
+            pending = reader.next(nextMove, nextTime);
+        }
+    }
+
+    bool finished() const
+    {
+        return !pending;
+    }
+
+private:
+
+    ReplaySolve solve = {};
+    ReplayReader reader;
+    double clock = 0.0;
+    bool pending = false;
+    LayerMove nextMove;
+    uint32_t nextTime = 0;
+
+};
+
+#endif
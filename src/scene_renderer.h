@@ -0,0 +1,148 @@
+#ifndef SCENE_RENDERER_H
+#define SCENE_RENDERER_H
+
+#include <stdio.h>
+#include <vector>
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include "camera.h"
+#include "gl_object.h"
+#include "scene_snapshot.h"
+#include "sticker_renderer.h"
+#include "stream_buffer.h"
+
+/** Draws SceneSnapshots with the shared sticker renderer. All their stickers live in one
+  * instance buffer, cube i owning its instances from offsets[i]. Only blocks whose
+  * version changed since they were last uploaded are uploaded, cubes outside the view
+  * frustum are skipped and every run of consecutive visible cubes is one draw. Uploads
+  * stream through a StreamBuffer, so changing stickers never waits for frames in flight. */
+class SceneRenderer
+{
+public:
+
+    // Black sticker outline width and corner rounding, in sticker units
+    float borderWidth = 0.04f;
+    float cornerRadius = 0.0f;
+
+    // Skip stickers facing away from the camera, invisible but for the gaps between pieces
+    bool hideBackStickers = false;
+
+    // Statistics of the last render
+    int visibleCubes = 0, drawCalls = 0;
+
+    // The renderer is shared between scenes and must outlive them
+    SceneRenderer(const StickerRenderer *renderer)
+        : renderer(renderer)
+    {}
+
+    const StreamBuffer &getUploads() const { return uploads; }
+
+    // False once the last render showed this snapshot with every cube at rest
+    bool needsRedraw(const SceneSnapshot &scene) const
+    {
+        return scene.version != renderedVersion || scene.animationEnd >= lastRenderTime;
+    }
+
+    // currentTime is on the simulation's clock, as animationEnd
+    void render(const SceneSnapshot &scene, const Camera &camera, double currentTime)
+    {
+        uploadInstances(scene);
+
+        renderer->begin(borderWidth, cornerRadius, hideBackStickers);
+        visibleCubes = drawCalls = 0;
+        int runStart = -1;
+        for (int i = 0; i <= (int)scene.cubes.size(); i++)
+        {
+            bool visible = i < (int)scene.cubes.size() &&
+                           camera.sphereVisible(scene.cubes[i].position, scene.cubes[i].boundingRadius);
+            if (visible)
+            {
+                visibleCubes++;
+                if (runStart < 0) runStart = i;
+            }
+            else if (runStart >= 0)
+            {
+                renderer->drawInstances(instanceTexture, offsets[runStart], offsets[i] - offsets[runStart]);
+                drawCalls++;
+                runStart = -1;
+            }
+        }
+        renderedVersion = scene.version;
+        lastRenderTime = currentTime;
+    }
+
+private:
+
+    const StickerRenderer *renderer;
+
+    // First instance and first version block of each cube, then the totals
+    std::vector<int> offsets, blockOffsets;
+    GLBuffer instanceVBO;
+    GLTexture instanceTexture;
+    StreamBuffer uploads;
+
+    // Version of every block in the instance buffer, 0 for never uploaded
+    std::vector<uint64_t> uploadedVersions;
+    uint64_t renderedVersion = 0;
+    double lastRenderTime = -1.0;
+
+    bool layoutMatches(const SceneSnapshot &scene) const
+    {
+        if (offsets.size() != scene.cubes.size() + 1) return false;
+        for (size_t i = 0; i < scene.cubes.size(); i++)
+            if (offsets[i + 1] - offsets[i] != (int)scene.cubes[i].instances.size()) return false;
+        return true;
+    }
+
+    // Reallocates when cubes were added, then uploads every block that changed
+    void uploadInstances(const SceneSnapshot &scene)
+    {
+        if (!layoutMatches(scene))
+        {
+            offsets.assign(1, 0);
+            blockOffsets.assign(1, 0);
+            for (const CubeSnapshot &cube : scene.cubes)
+            {
+                offsets.push_back(offsets.back() + cube.instances.size());
+                blockOffsets.push_back(blockOffsets.back() + cube.blockVersions.size());
+            }
+            uploadedVersions.assign(blockOffsets.back(), 0);
+
+            GLint maxTexels = 0;
+            glGetIntegerv(GL_MAX_TEXTURE_BUFFER_SIZE, &maxTexels);
+            if ((size_t)maxTexels < (size_t)offsets.back() * STICKER_TEXELS)
+                fprintf(stderr, "Warning: %d stickers exceed the buffer texture limit of %d texels\n", offsets.back(), maxTexels);
+
+            instanceVBO = GLBuffer::create();
+            glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+            glBufferData(GL_ARRAY_BUFFER, (size_t)offsets.back() * sizeof(StickerInstance), NULL, GL_DYNAMIC_DRAW);
+            glBindBuffer(GL_ARRAY_BUFFER, 0);
+            instanceTexture = renderer->createBufferTexture(instanceVBO);
+        }
+
+        // Runs of consecutive changed blocks go up in one upload
+        for (size_t i = 0; i < scene.cubes.size(); i++)
+        {
+            const CubeSnapshot &cube = scene.cubes[i];
+            uint64_t *uploaded = uploadedVersions.data() + blockOffsets[i];
+            int blocks = cube.blockVersions.size();
+            for (int b = 0; b < blocks; )
+            {
+                if (uploaded[b] == cube.blockVersions[b])
+                {
+                    b++;
+                    continue;
+                }
+                int first = b;
+                for (; b < blocks && uploaded[b] != cube.blockVersions[b]; b++) uploaded[b] = cube.blockVersions[b];
+                int start = first * SNAPSHOT_BLOCK, end = glm::min(b * SNAPSHOT_BLOCK, (int)cube.instances.size());
+                uploads.upload(instanceVBO, (size_t)(offsets[i] + start) * sizeof(StickerInstance),
+                               cube.instances.data() + start, (size_t)(end - start) * sizeof(StickerInstance));
+            }
+        }
+        uploads.endFrame();
+    }
+
+};
+
+#endif
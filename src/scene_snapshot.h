@@ -0,0 +1,40 @@
+#ifndef SCENE_SNAPSHOT_H
+#define SCENE_SNAPSHOT_H
+
+#include <stdint.h>
+#include <vector>
+#include <glm/glm.hpp>
+#include "sticker_renderer.h"
+
+// Stickers per version stamp. Snapshots copy, and renderers upload, whole blocks
+#define SNAPSHOT_BLOCK 64
+
+/** Everything needed to draw one cube, as taken by Cube::snapshot. blockVersions stamps
+  * each SNAPSHOT_BLOCK instances with the change that last wrote them, so both taking a
+  * snapshot and uploading one only touch the blocks that changed. */
+struct CubeSnapshot
+{
+    std::vector<StickerInstance> instances;
+    std::vector<uint64_t> blockVersions;
+    glm::vec3 position;
+    float boundingRadius;
+};
+
+/** What the renderer sees of a CubeScene. The simulation owns the scene and publishes
+  * snapshots, the renderer only ever reads them. */
+struct SceneSnapshot
+{
+    std::vector<CubeSnapshot> cubes;
+
+    // When the latest turn of any cube ends, on the simulation's clock
+    double animationEnd = 0.0;
+
+    // What the turn times of the instances count from. FrameUniforms::time is the time
+    // to draw at less this
+    double epoch = 0.0;
+
+    // Increases with every snapshot that differs from the one before
+    uint64_t version = 0;
+};
+
+#endif
@@ -0,0 +1,98 @@
+#ifndef SCRAMBLE_GENERATOR_H
+#define SCRAMBLE_GENERATOR_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string>
+#include <thread>
+#include <vector>
+#include "random.h"
+#include "scrambler.h"
+
+#define SCRAMBLE_CHUNK_SIZE 4096
+#define SCRAMBLE_MAX_MOVES 64
+
+/** Bulk scramble generation across threads. Scrambles are produced in fixed-size chunks
+  * and chunk c always draws from the seed's stream jumped c times, so the output only
+  * depends on the seed, never on the thread count. Each round builds one chunk per
+  * thread while the previous round is written out in order. */
+class ScrambleGenerator
+{
+public:
+
+    uint64_t seed = 0;
+    int threads = 1;
+    int length = SCRAMBLE_MOVES_LENGTH;  // Random-move scrambles only
+    bool randomState = false;
+
+    void run(uint64_t count, FILE *out)
+    {
+        if (threads < 1) threads = 1;
+        if (length > SCRAMBLE_MAX_MOVES) length = SCRAMBLE_MAX_MOVES;
+        uint64_t chunks = (count + SCRAMBLE_CHUNK_SIZE - 1) / SCRAMBLE_CHUNK_SIZE;
+
+        // The random-state solver tables are shared, build them before the workers start
+        if (randomState) SolverTables::get();
+
+        Random cursor(seed);
+        std::vector<std::string> building(threads), writing(threads);
+        uint64_t written = 0;
+        for (uint64_t first = 0; first < chunks; first += threads)
+        {
+            std::vector<std::thread> workers;
+            for (int t = 0; t < threads && first + t < chunks; t++)
+            {
+                uint64_t chunk = first + t;
+                uint64_t n = count - chunk * SCRAMBLE_CHUNK_SIZE;
+                if (n > SCRAMBLE_CHUNK_SIZE) n = SCRAMBLE_CHUNK_SIZE;
+
+                workers.emplace_back(&ScrambleGenerator::buildChunk, this, cursor, (int)n, &building[t]);
+                cursor.jump();
+            }
+
+            write(writing, written, out);
+            for (std::thread &worker : workers) worker.join();
+            building.swap(writing);
+            written = workers.size();
+        }
+        write(writing, written, out);
+        fflush(out);
+    }
+
+private:
+
+    void buildChunk(Random rng, int n, std::string *text)
+    {
+        int moves[SCRAMBLE_MAX_MOVES];
+        char line[4 * SCRAMBLE_MAX_MOVES + 1];
+        Scrambler *scrambler = randomState ? new Scrambler(rng.next()) : NULL;
+
+        text->clear();
+        for (int i = 0; i < n; i++)
+        {
+            int moveCount = length;
+            if (scrambler)
+            {
+                std::vector<int> solution;
+                scrambler->nextRandomState(solution);
+                moveCount = solution.size();
+                for (int j = 0; j < moveCount; j++) moves[j] = solution[j];
+            }
+            else Scrambler::randomMoves(rng, length, moves);
+
+            int chars = Scrambler::format(moves, moveCount, line);
+            line[chars++] = '\n';
+            text->append(line, chars);
+        }
+        delete scrambler;
+    }
+
+    static void write(const std::vector<std::string> &texts, uint64_t count, FILE *out)
+    {
+        for (uint64_t i = 0; i < count; i++)
+            fwrite(texts[i].data(), 1, texts[i].size(), out);
+    }
+
+};
+
+#endif
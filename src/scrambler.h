@@ -0,0 +1,136 @@
+#ifndef SCRAMBLER_H
+#define SCRAMBLER_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string>
+#include <vector>
+#include "cubie.h"
+#include "random.h"
+#include "solver.h"
+
+#define SCRAMBLE_MOVES_LENGTH 25
+
+/** Random-state scrambler. Picks a uniformly random solvable state and returns the
+  * inverse of a fast solution for it, so applying the scramble to a solved cube
+  * reaches that state. Each scrambler draws from its own seeded stream. */
+class Scrambler
+{
+public:
+
+    Scrambler(uint64_t seed)
+        : rng(seed)
+    {}
+
+    std::string next()
+    {
+        std::vector<int> moves;
+        nextRandomState(moves);
+
+        char buffer[4 * 64];
+        format(moves.data(), moves.size(), buffer);
+        return buffer;
+    }
+
+    /** Scramble for an NxN cube: random state for 3x3, otherwise random turns of outer
+      * blocks ("R", "Rw", "3Rw", ...) as long as the WCA's, 20 * (N - 2) moves. Faces
+      * follow randomMoves' rule: blocks are at most N / 2 deep, so opposite faces never
+      * share a layer and commute. */
+    std::string next(int size)
+    {
+        if (size == 3) return next();
+
+        int length = size > 3 ? 20 * (size - 2) : SCRAMBLE_MOVES_LENGTH;
+        std::string sequence;
+        char token[16];
+        int last = -1, beforeLast = -1;
+        for (int i = 0; i < length; i++)
+        {
+            int face;
+            do face = rng.below(6);
+            while (face == last || (face == beforeLast && last % 3 == face % 3));
+            beforeLast = last;
+            last = face;
+
+            int depth = 1 + rng.below(size > 1 ? size / 2 : 1);
+            const char *modifier = CubieCube::moveName(rng.below(3)) + 1;
+            if      (depth == 1) snprintf(token, sizeof(token), "%c%s", "URFDLB"[face], modifier);
+            else if (depth == 2) snprintf(token, sizeof(token), "%cw%s", "URFDLB"[face], modifier);
+            else                 snprintf(token, sizeof(token), "%d%cw%s", depth, "URFDLB"[face], modifier);
+
+            if (i > 0) sequence += ' ';
+            sequence += token;
+        }
+        return sequence;
+    }
+
+    void nextRandomState(std::vector<int> &moves)
+    {
+        CubieCube state = randomState(rng);
+
+        std::vector<int> solution;
+        solver.solve(state, solution);
+
+        moves.clear();
+        for (int i = (int)solution.size() - 1; i >= 0; i--)
+            moves.push_back(CubieCube::inverseMove(solution[i]));
+    }
+
+    static CubieCube randomState(Random &rng)
+    {
+        CubieCube c;
+        c.setCornerPerm(rng.below(N_CORNER_PERM));
+        c.setTwist(rng.below(N_TWIST));
+        c.setFlip(rng.below(N_FLIP));
+
+        // Fisher-Yates over all 12 edges, then fix the parity to match the corners
+        for (int i = NUM_EDGES - 1; i > 0; i--)
+        {
+            int j = rng.below(i + 1);
+            int8_t tmp = c.ep[i]; c.ep[i] = c.ep[j]; c.ep[j] = tmp;
+        }
+        if (c.edgeParity() != c.cornerParity())
+        {
+            int8_t tmp = c.ep[UR]; c.ep[UR] = c.ep[UF]; c.ep[UF] = tmp;
+        }
+        return c;
+    }
+
+    /** Random-move scramble without redundant moves: never the same face twice in a row
+      * and never X Y X when X and Y are opposite faces, since those moves commute. */
+    static void randomMoves(Random &rng, int length, int *moves)
+    {
+        int last = -1, beforeLast = -1;
+        for (int i = 0; i < length; i++)
+        {
+            int face;
+            do face = rng.below(6);
+            while (face == last || (face == beforeLast && last % 3 == face % 3));
+
+            moves[i] = face * 3 + rng.below(3);
+            beforeLast = last;
+            last = face;
+        }
+    }
+
+    // Write "R U2 F'" style text, returns the number of characters written
+    static int format(const int *moves, int n, char *out)
+    {
+        char *p = out;
+        for (int i = 0; i < n; i++)
+        {
+            if (i > 0) *p++ = ' ';
+            for (const char *name = CubieCube::moveName(moves[i]); *name; name++) *p++ = *name;
+        }
+        *p = '\0';
+        return p - out;
+    }
+
+private:
+
+    Random rng;
+    Solver solver;
+
+};
+
+#endif
@@ -0,0 +1,227 @@
+#ifndef SELF_TEST_H
+#define SELF_TEST_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <string>
+#include <vector>
+#include <zlib.h>
+#include "cube.h"
+#include "net_renderer.h"
+#include "replay.h"
+#include "scrambler.h"
+
+/** Checks of the CPU-side code, run by --self-test without a window or GL context.
+  * Every failed check is printed, run returns the number that failed. */
+class SelfTest
+{
+public:
+
+    int run()
+    {
+        netStickerSizes();
+        queueAfterSequence();
+        replayEscapedLayers();
+        replayCubeSizes();
+        scramblerNoRedundantFaces();
+
+        if (failures == 0) printf("All %d checks passed\n", checks);
+        else               printf("%d of %d checks failed\n", failures, checks);
+        return failures;
+    }
+
+private:
+
+    int checks = 0, failures = 0;
+
+    void check(bool ok, const char *what)
+    {
+        checks++;
+        if (ok) return;
+        failures++;
+        fprintf(stderr, "FAIL: %s\n", what);
+    }
+
+    // A move queued right after moveSequence waits for the sequence's turns to end
+    void queueAfterSequence()
+    {
+        Cube cube(1.0f, 1);
+        cube.perFrame(1.0);
+        cube.moveSequence("R U F");
+        cube.move("L");
+        cube.perFrame(1.0 + TURN_DURATION / 2.0);
+        check(cube.queuedMoves() == 1, "cube: move after a sequence waits for it");
+        cube.perFrame(1.0 + TURN_DURATION);
+        check(cube.queuedMoves() == 0 && cube.animationEndTime() >= 1.0 + 2.0 * TURN_DURATION - 1e-6,
+              "cube: move after a sequence starts as it ends");
+    }
+
+    // A move whose layers are in the layers stream decodes, and ends the solve when they
+    // are cut off rather than passing on a partial varint
+    void replayEscapedLayers()
+    {
+        // One quarter turn of axis 0 coded 15, then the layers and a group of times with
+        // the three bytes readers may read past the end
+        uint8_t whole[] = { 0x4F, 0x05, 0x06, 0x00, 0x07, 0, 0, 0 };
+        // Cut off in the last layer, whose partial value 3 would pass as layers 0 to 3
+        uint8_t cut[] = { 0x4F, 0x00, 0x83, 0x00, 0x07, 0, 0, 0 };
+        ReplaySolve solve = { 7, NULL, 1, whole, whole + 1, whole + 3, whole + 5 };
+
+        LayerMove move;
+        uint32_t time;
+        ReplayReader reader(solve);
+        check(reader.next(move, time) && move.firstLayer == 5 && move.lastLayer == 6 && time == 7,
+              "replay: escaped layers decode");
+        check(!reader.next(move, time), "replay: solve ends after its moves");
+
+        solve = { 7, NULL, 1, cut, cut + 1, cut + 3, cut + 5 };
+        reader = ReplayReader(solve);
+        check(!reader.next(move, time), "replay: truncated escaped layers end the solve");
+        check(!reader.next(move, time), "replay: nothing after truncated escaped layers");
+        ReplayReader batch(solve);
+        LayerMove moves[4];
+        uint32_t times[4];
+        check(batch.read(moves, times, 4) == 0, "replay: batch read stops at truncated escaped layers");
+    }
+
+    // The writer refuses cubes the reader would reject, the largest it takes reads back
+    void replayCubeSizes()
+    {
+        char path[] = "/tmp/cube_self_test_XXXXXX";
+        int fd = mkstemp(path);
+        if (fd < 0)
+        {
+            check(false, "replay: temporary file");
+            return;
+        }
+        close(fd);
+
+        ReplayWriter writer;
+        std::vector<LayerMove> moves;
+        std::vector<uint32_t> times;
+        bool opened = writer.open(path);
+        check(opened && !writer.addSolve(FaceletCube(REPLAY_MAX_CUBE_SIZE + 1), moves, times),
+              "replay: writer rejects cubes over the largest size");
+        check(opened && writer.addSolve(FaceletCube(REPLAY_MAX_CUBE_SIZE), moves, times) && writer.finish(),
+              "replay: writer takes the largest cube size");
+
+        ReplayArchive archive;
+        ReplaySolve solve;
+        check(archive.open(path) && archive.size() == 1 && archive.solve(0, solve) && solve.cubeSize == REPLAY_MAX_CUBE_SIZE,
+              "replay: largest cube size reads back");
+        archive.close();
+        unlink(path);
+    }
+
+    // NxN scrambles never turn a face twice in a row, nor X Y X with X and Y opposite
+    void scramblerNoRedundantFaces()
+    {
+        static const char faces[] = "URFDLB";
+        Scrambler scrambler(1);
+        for (int size = 4; size <= 5; size++)
+        {
+            bool redundant = false;
+            for (int n = 0; n < 200; n++)
+            {
+                std::string scramble = scrambler.next(size);
+                std::vector<int> sequence;
+                for (char c : scramble)
+                    if (const char *face = strchr(faces, c)) sequence.push_back(face - faces);
+                for (size_t i = 1; i < sequence.size(); i++)
+                {
+                    redundant |= sequence[i] == sequence[i - 1];
+                    redundant |= i > 1 && sequence[i] == sequence[i - 2] && sequence[i] % 3 == sequence[i - 1] % 3;
+                }
+            }
+            check(!redundant, size == 4 ? "scrambler: no redundant faces, 4x4" : "scrambler: no redundant faces, 5x5");
+        }
+    }
+
+    /** The smallest sticker size of each view still shows every colour: the centre of
+      * U1 in the net, and of the B3 side strip in the last layer view, a quarter sticker
+      * thick. Both are read back from the PNG. */
+    void netStickerSizes()
+    {
+        char dir[] = "/tmp/cube_self_test_XXXXXX";
+        if (mkdtemp(dir) == NULL)
+        {
+            check(false, "net renderer: temporary directory");
+            return;
+        }
+        char path[64];
+        snprintf(path, sizeof(path), "%s/000000.png", dir);
+
+        const char *scramble = "R U R' U'";
+        CubieCube state;
+        state.applySequence(scramble);
+        int8_t facelets[NUM_FACELETS];
+        state.facelets(facelets);
+
+        for (int view = NetRenderer::NET; view <= NetRenderer::LAST_LAYER; view++)
+        {
+            NetRenderer renderer;
+            renderer.view = (NetRenderer::View)view;
+            renderer.stickerSize = renderer.minStickerSize();
+            int size = renderer.stickerSize;
+            FILE *scrambles = tmpfile();
+            fprintf(scrambles, "%s\n", scramble);
+            rewind(scrambles);
+            bool written = renderer.run(scrambles, dir) == 1;
+            fclose(scrambles);
+
+            int x = view == NetRenderer::NET ? 3 * size + size / 2 : size / 4 + size / 2;
+            int y = view == NetRenderer::NET ? size / 2 : size / 8;
+            int facelet = view == NetRenderer::NET ? 0 : 47;
+            const float *rgb = colourScheme[faceColours[facelets[facelet]]];
+            uint8_t pixel[3];
+            bool coloured = written && readPixel(path, x, y, pixel);
+            for (int k = 0; k < 3; k++) coloured &= pixel[k] == (uint8_t)(255 * rgb[k]);
+            check(coloured, view == NetRenderer::NET ? "net renderer: smallest sticker, net"
+                                                     : "net renderer: smallest sticker, last layer");
+            unlink(path);
+        }
+        rmdir(dir);
+    }
+
+    // RGB of one pixel of an unfiltered palette PNG, as PNG::writeIndexed writes them
+    static bool readPixel(const char *path, int x, int y, uint8_t *rgb)
+    {
+        FILE *file = fopen(path, "rb");
+        if (file == NULL) return false;
+        std::vector<uint8_t> data;
+        uint8_t buffer[4096];
+        for (size_t n; (n = fread(buffer, 1, sizeof(buffer), file)) > 0; ) data.insert(data.end(), buffer, buffer + n);
+        fclose(file);
+
+        auto bigEndian = [&](size_t at) {
+            return (uint32_t)data[at] << 24 | data[at + 1] << 16 | data[at + 2] << 8 | data[at + 3];
+        };
+        uint32_t width = 0, height = 0;
+        std::vector<uint8_t> palette, compressed;
+        for (size_t at = 8; at + 12 <= data.size(); )
+        {
+            uint32_t length = bigEndian(at);
+            if (at + 12 + length > data.size()) return false;
+            const uint8_t *chunk = data.data() + at + 8;
+            if (memcmp(&data[at + 4], "IHDR", 4) == 0) width = bigEndian(at + 8), height = bigEndian(at + 12);
+            if (memcmp(&data[at + 4], "PLTE", 4) == 0) palette.assign(chunk, chunk + length);
+            if (memcmp(&data[at + 4], "IDAT", 4) == 0) compressed.insert(compressed.end(), chunk, chunk + length);
+            at += 12 + length;
+        }
+        if ((uint32_t)x >= width || (uint32_t)y >= height) return false;
+
+        // Every row starts with its filter type, which is always none
+        std::vector<uint8_t> raw((size_t)(width + 1) * height);
+        uLongf rawSize = raw.size();
+        if (uncompress(raw.data(), &rawSize, compressed.data(), compressed.size()) != Z_OK || rawSize != raw.size()) return false;
+        size_t index = raw[(size_t)(width + 1) * y + 1 + x];
+        if (3 * index + 3 > palette.size()) return false;
+        memcpy(rgb, &palette[3 * index], 3);
+        return true;
+    }
+
+};
+
+#endif
@@ -4,14 +4,37 @@
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
 #include <glm/glm.hpp>
+#include "gl_object.h"
 
 #include <stdio.h>
+#include <string.h>
+#include <string>
+#include <unordered_map>
+
+#define FRAME_UNIFORMS_BINDING 0
+
+/** "#define NAME value" line for shader sources, so shaders size their loops and buffers
+  * from the same macro as the C++ side. Goes after the #version line:
+  *     "#version 330 core\n" SHADER_DEFINE(STICKER_BATCH) R"(...)" */
+#define SHADER_DEFINE(name) "#define " #name " " SHADER_STRINGIFY(name) "\n"
+#define SHADER_STRINGIFY(value) SHADER_STRINGIFY_(value)
+#define SHADER_STRINGIFY_(value) #value
+
+/** Mirrors the std140 "Frame" uniform block shared by every shader:
+  *     layout(std140) uniform Frame { mat4 projectionView; vec3 cameraPosition; float time; };
+  * std140 aligns the vec3 to 16 bytes, time fills the rest of its slot. */
+struct FrameUniforms
+{
+    glm::mat4 projectionView;
+    glm::vec3 cameraPosition;
+    float time;
+};
 
 class Shader
 {
 public:
 
-    GLuint ID;
+    GLProgram ID;
 
     Shader() {}
 
@@ -24,7 +47,7 @@ public:
         GLuint fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
         fragmentShader = compileShader(fragmentShader, fragmentShaderSource);
 
-        ID = glCreateProgram();
+        ID = GLProgram::create();
         glAttachShader(ID, vertexShader);
         glAttachShader(ID, fragmentShader);
         glLinkProgram(ID);
@@ -42,10 +65,52 @@ public:
         // Clean up shaders as they're no longer needed
         glDeleteShader(vertexShader);
         glDeleteShader(fragmentShader);
+
+        cacheUniformLocations();
+
+        // Every shader that declares the per-frame block reads it from the same binding
+        GLuint frameBlock = glGetUniformBlockIndex(ID, "Frame");
+        if (frameBlock != GL_INVALID_INDEX)
+            glUniformBlockBinding(ID, frameBlock, FRAME_UNIFORMS_BINDING);
+    }
+
+    // Location cached at link time, -1 if the program has no such active uniform
+    GLint uniform(const char *name) const
+    {
+        auto it = uniforms.find(name);
+        return it == uniforms.end() ? -1 : it->second;
     }
 
 private:
 
+    std::unordered_map<std::string, GLint> uniforms;
+
+    void cacheUniformLocations()
+    {
+        GLint count = 0;
+        glGetProgramiv(ID, GL_ACTIVE_UNIFORMS, &count);
+        for (GLint i = 0; i < count; i++)
+        {
+            GLchar name[256];
+            GLint size;
+            GLenum type;
+            glGetActiveUniform(ID, i, sizeof(name), NULL, &size, &type, name);
+
+            // Members of uniform blocks have no location
+            GLint location = glGetUniformLocation(ID, name);
+            if (location < 0) continue;
+
+            // Arrays are reported as "name[0]", store them under "name" as well
+            char *bracket = strchr(name, '[');
+            uniforms[name] = location;
+            if (bracket)
+            {
+                *bracket = '\0';
+                uniforms[name] = location;
+            }
+        }
+    }
+
     GLuint compileShader(GLuint shader, const char* shaderSource)
     {
         glShaderSource(shader, 1, &shaderSource, NULL);
@@ -66,4 +131,37 @@ private:
 
 };
 
+/** A uniform buffer bound to a fixed binding point, for data that is uploaded once per
+  * frame and read by several shaders. */
+class UniformBuffer
+{
+public:
+
+    GLBuffer ID;
+
+    UniformBuffer() {}
+
+    UniformBuffer(GLsizeiptr size, GLuint binding)
+        : size(size)
+    {
+        ID = GLBuffer::create();
+        glBindBuffer(GL_UNIFORM_BUFFER, ID);
+        glBufferData(GL_UNIFORM_BUFFER, size, NULL, GL_DYNAMIC_DRAW);
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+        glBindBufferBase(GL_UNIFORM_BUFFER, binding, ID);
+    }
+
+    void update(const void *data)
+    {
+        glBindBuffer(GL_UNIFORM_BUFFER, ID);
+        glBufferSubData(GL_UNIFORM_BUFFER, 0, size, data);
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    }
+
+private:
+
+    GLsizeiptr size;
+
+};
+
 #endif
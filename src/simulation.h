@@ -0,0 +1,187 @@
+#ifndef SIMULATION_H
+#define SIMULATION_H
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <GLFW/glfw3.h>
+#include "cube_scene.h"
+#include "scene_snapshot.h"
+#include "triple_buffer.h"
+
+// Fixed steps per second. The simulation runs them while moves are queued or onTick
+// keeps the scene changing on its own
+#define SIMULATION_TICK_RATE 240
+
+// Most steps caught up on at once, after a stall the rest are dropped
+#define SIMULATION_MAX_STEPS 60
+
+// Seconds between moves of the epoch turn times count from. Their floats then stay
+// below 4096 s, where they resolve 2^-12 s (0.24 ms, about a seventeenth of a step)
+#define SIMULATION_EPOCH_INTERVAL 3600.0
+
+/** Runs a CubeScene on its own thread. Key presses and other commands are queued to it,
+  * and every change it makes is published as a SceneSnapshot through a TripleBuffer, so
+  * the render thread never waits for the simulation nor the simulation for a frame:
+  * input is applied as soon as it arrives, however long frames take. With no moves
+  * queued and no onTick the thread sleeps until input arrives.
+  *
+  * Time advances in fixed steps of the double precision, monotonic glfwGetTime clock:
+  * step n is at n / SIMULATION_TICK_RATE seconds, onTick always gets the same dt and
+  * turns start on steps, however the thread is woken. Given the same input on the same
+  * steps the scene goes through the same states, whatever the frame rate. The render
+  * thread draws at renderTime, a step behind, when the steps up to then are all taken:
+  * turns are animated from their start times, so every frame shows the scene exactly
+  * as it is at its time, in between steps.
+  *
+  * The scene belongs to the simulation thread once start is called. Set it up, and
+  * onTick, before that. */
+class Simulation
+{
+public:
+
+    CubeScene scene;
+
+    // Called every step on the simulation thread with the seconds per step
+    std::function<void(CubeScene&, double)> onTick;
+
+    Simulation() {}
+
+    ~Simulation()
+    {
+        stop();
+    }
+
+    Simulation(const Simulation &) = delete;
+    Simulation &operator=(const Simulation &) = delete;
+
+    void start()
+    {
+        if (thread.joinable()) return;
+        running = true;
+        step = glfwGetTime() * SIMULATION_TICK_RATE;
+        publish();
+        thread = std::thread(&Simulation::run, this);
+    }
+
+    void stop()
+    {
+        {
+            std::lock_guard<std::mutex> lock(inputMutex);
+            running = false;
+        }
+        wake.notify_one();
+        if (thread.joinable()) thread.join();
+    }
+
+    // Any thread: every cube of the scene follows the key
+    void postKey(int key)
+    {
+        post([key](CubeScene &scene) {
+            for (int i = 0; i < scene.size(); i++) scene.cube(i).keyCallback(key);
+        });
+    }
+
+    // Any thread: runs the command on the simulation thread, in the order posted
+    void post(std::function<void(CubeScene&)> command)
+    {
+        {
+            std::lock_guard<std::mutex> lock(inputMutex);
+            commands.push_back(std::move(command));
+        }
+        wake.notify_one();
+    }
+
+    // Render thread: the latest snapshot, unchanged until the next call
+    const SceneSnapshot &latestSnapshot()
+    {
+        snapshots.consume();
+        return snapshots.front();
+    }
+
+    // The time a frame drawn now shows, on the simulation's clock
+    static double renderTime()
+    {
+        return glfwGetTime() - 1.0 / SIMULATION_TICK_RATE;
+    }
+
+private:
+
+    std::thread thread;
+    std::mutex inputMutex;
+    std::condition_variable wake;
+    std::vector<std::function<void(CubeScene&)>> commands;
+    bool running = false;
+
+    TripleBuffer<SceneSnapshot> snapshots;
+    uint64_t publishedVersion = 0;
+
+    // The last step taken
+    uint64_t step = 0;
+
+    static double stepTime(uint64_t step)
+    {
+        return step / (double)SIMULATION_TICK_RATE;
+    }
+
+    void run()
+    {
+        std::vector<std::function<void(CubeScene&)>> pending;
+        while (true)
+        {
+            {
+                std::unique_lock<std::mutex> lock(inputMutex);
+                auto woken = [this]() { return !running || !commands.empty(); };
+                if (onTick || scene.queuedMoves() > 0)
+                {
+                    double untilNext = stepTime(step + 1) - glfwGetTime();
+                    if (untilNext > 0.0) wake.wait_for(lock, std::chrono::duration<double>(untilNext), woken);
+                }
+                else wake.wait(lock, woken);
+                if (!running) break;
+                pending.swap(commands);
+            }
+
+            // Without onTick nothing happens between steps that the queues can't catch up
+            // on at once, so the steps missed asleep are skipped
+            uint64_t due = glfwGetTime() * SIMULATION_TICK_RATE;
+            if (!onTick) step = std::max(step, due);
+            else if (due > step + SIMULATION_MAX_STEPS) step = due - SIMULATION_MAX_STEPS;
+            while (step < due)
+            {
+                step++;
+                scene.perFrame(stepTime(step));
+                onTick(scene, 1.0 / SIMULATION_TICK_RATE);
+
+                // Moves just queued on an idle cube start right away
+                scene.perFrame(stepTime(step));
+            }
+
+            // Input takes effect on the latest step
+            scene.perFrame(stepTime(step));
+            for (auto &command : pending) command(scene);
+            pending.clear();
+            scene.perFrame(stepTime(step));
+
+            if (stepTime(step) - scene.getEpoch() > SIMULATION_EPOCH_INTERVAL) scene.rebase(stepTime(step));
+            if (scene.version() != publishedVersion) publish();
+        }
+    }
+
+    void publish()
+    {
+        scene.snapshot(snapshots.back());
+        publishedVersion = snapshots.back().version;
+        snapshots.publish();
+
+        // Wake the render thread should it be waiting for events
+        glfwPostEmptyEvent();
+    }
+
+};
+
+#endif
@@ -0,0 +1,468 @@
+#ifndef SOLVER_H
+#define SOLVER_H
+
+#include <stdint.h>
+#include <string.h>
+#include <vector>
+#include "cubie.h"
+
+#define N_PHASE2_MOVES 10      // U, D quarter and half turns plus R2, F2, L2, B2
+#define N_HALF_TURNS 6
+#define N_CORNER_COSETS 420    // corner permutations of G1 modulo those of G2
+#define N_EDGE_COSETS 140      // edge permutations of G1 modulo those of G2
+#define N_G2_CORNER_PERMS 96
+#define N_G2_EDGE_PERMS 6912
+#define N_EDGE_PERM (N_UD_EDGE_PERM * N_SLICE_PERM)
+#define SOLVER_PHASE1_LEAVES 4
+
+/** Move and distance tables shared by every Solver. They are built once on first use,
+  * which takes about a second and 12 MB.
+  *
+  * The solve runs in three stages: an IDA* search into G1 = <U, D, R2, L2, F2, B2>
+  * (Kociemba's phase 1), then Thistlethwaite's last two stages into
+  * G2 = <U2, D2, R2, L2, F2, B2> and to the solved state. Those two stages are small
+  * enough to store exact distances, so they are walked greedily without searching. */
+struct SolverTables
+{
+    // Phase 1 coordinates and pruning
+    uint16_t twistMove[N_TWIST][NUM_FACE_MOVES];
+    uint16_t flipMove[N_FLIP][NUM_FACE_MOVES];
+    uint16_t sliceMove[N_SLICE][NUM_FACE_MOVES];
+    uint8_t twistSlicePrune[N_TWIST * N_SLICE];
+    uint8_t flipSlicePrune[N_FLIP * N_SLICE];
+    uint8_t twistFlipPrune[N_TWIST * N_FLIP];
+
+    // Permutations within G1, indexed by phase 2 move
+    uint16_t cornerPermMove[N_CORNER_PERM][N_PHASE2_MOVES];
+    uint16_t udEdgePermMove[N_UD_EDGE_PERM][N_PHASE2_MOVES];
+    uint8_t slicePermMove[N_SLICE_PERM][N_PHASE2_MOVES];
+
+    // G1 -> G2: which coset of the G2 permutations the corners and edges are in
+    uint16_t cornerCoset[N_CORNER_PERM];
+    uint8_t edgeCoset[N_EDGE_PERM];
+    uint8_t cosetDistance[N_CORNER_COSETS * N_EDGE_COSETS];
+
+    // G2 -> solved: index of the permutation within G2, or 0xFFFF outside of it
+    uint16_t cornerG2Index[N_CORNER_PERM];
+    uint16_t edgeG2Index[N_EDGE_PERM];
+    uint8_t g2Distance[N_G2_CORNER_PERMS * N_G2_EDGE_PERMS];
+
+    static const int *phase2Moves()
+    {
+        static const int moves[N_PHASE2_MOVES] = { 0, 1, 2, 9, 10, 11, 4, 13, 7, 16 };
+        return moves;
+    }
+
+    // Indices into phase2Moves() of the half turns
+    static const int *halfTurns()
+    {
+        static const int moves[N_HALF_TURNS] = { 1, 4, 6, 7, 8, 9 };
+        return moves;
+    }
+
+    static const SolverTables &get()
+    {
+        static const SolverTables *tables = new SolverTables();
+        return *tables;
+    }
+
+private:
+
+    SolverTables()
+    {
+        initPhase1Tables();
+        initPermutationTables();
+        initCosetTables();
+        initG2Tables();
+    }
+
+    void initPhase1Tables()
+    {
+        CubieCube c;
+        for (int i = 0; i < N_TWIST; i++)
+        {
+            for (int m = 0; m < NUM_FACE_MOVES; m++)
+            {
+                c = CubieCube(); c.setTwist(i); c.move(m);
+                twistMove[i][m] = c.twist();
+            }
+        }
+        for (int i = 0; i < N_FLIP; i++)
+        {
+            for (int m = 0; m < NUM_FACE_MOVES; m++)
+            {
+                c = CubieCube(); c.setFlip(i); c.move(m);
+                flipMove[i][m] = c.flip();
+            }
+        }
+        for (int i = 0; i < N_SLICE; i++)
+        {
+            for (int m = 0; m < NUM_FACE_MOVES; m++)
+            {
+                c = CubieCube(); c.setSlice(i); c.move(m);
+                sliceMove[i][m] = c.slice();
+            }
+        }
+
+        buildDistanceTable(twistSlicePrune, N_TWIST, N_SLICE, twistMove[0], sliceMove[0], NUM_FACE_MOVES);
+        buildDistanceTable(flipSlicePrune, N_FLIP, N_SLICE, flipMove[0], sliceMove[0], NUM_FACE_MOVES);
+        buildDistanceTable(twistFlipPrune, N_TWIST, N_FLIP, twistMove[0], flipMove[0], NUM_FACE_MOVES);
+    }
+
+    void initPermutationTables()
+    {
+        CubieCube c;
+        for (int i = 0; i < N_CORNER_PERM; i++)
+        {
+            for (int k = 0; k < N_PHASE2_MOVES; k++)
+            {
+                c = CubieCube(); c.setCornerPerm(i); c.move(phase2Moves()[k]);
+                cornerPermMove[i][k] = c.cornerPerm();
+            }
+        }
+        for (int i = 0; i < N_UD_EDGE_PERM; i++)
+        {
+            for (int k = 0; k < N_PHASE2_MOVES; k++)
+            {
+                c = CubieCube(); c.setUDEdgePerm(i); c.move(phase2Moves()[k]);
+                udEdgePermMove[i][k] = c.udEdgePerm();
+            }
+        }
+        for (int i = 0; i < N_SLICE_PERM; i++)
+        {
+            for (int k = 0; k < N_PHASE2_MOVES; k++)
+            {
+                c = CubieCube(); c.setSlicePerm(i); c.move(phase2Moves()[k]);
+                slicePermMove[i][k] = c.slicePerm();
+            }
+        }
+    }
+
+    /** A state s is in G2 exactly when its coset G2*s is G2 itself, and applying a move
+      * m maps the coset G2*s to G2*s*m. Composing g before s relabels the pieces of s
+      * through g, so each coset is found by relabeling one member with every G2
+      * permutation. Corners and edges are handled separately since G2 is the direct
+      * product of its corner and edge permutations. */
+    void initCosetTables()
+    {
+        std::vector<uint16_t> g2Corners = g2CornerPerms();
+        std::vector<int8_t> corners(g2Corners.size() * NUM_CORNERS);
+        for (size_t h = 0; h < g2Corners.size(); h++)
+        {
+            CubieCube c; c.setCornerPerm(g2Corners[h]);
+            memcpy(&corners[h * NUM_CORNERS], c.cp, NUM_CORNERS);
+        }
+
+        memset(cornerCoset, 0xFF, sizeof(cornerCoset));
+        int cosets = 0;
+        for (int i = 0; i < N_CORNER_PERM; i++)
+        {
+            if (cornerCoset[i] != 0xFFFF) continue;
+
+            CubieCube c; c.setCornerPerm(i);
+            for (size_t h = 0; h < g2Corners.size(); h++)
+            {
+                CubieCube r;
+                for (int j = 0; j < NUM_CORNERS; j++) r.cp[j] = corners[h * NUM_CORNERS + c.cp[j]];
+                cornerCoset[r.cornerPerm()] = cosets;
+            }
+            cosets++;
+        }
+
+        std::vector<uint32_t> g2Edges = g2EdgePerms();
+        std::vector<int8_t> edges(g2Edges.size() * NUM_EDGES);
+        for (size_t h = 0; h < g2Edges.size(); h++)
+        {
+            CubieCube c; c.setUDEdgePerm(g2Edges[h] / N_SLICE_PERM); c.setSlicePerm(g2Edges[h] % N_SLICE_PERM);
+            memcpy(&edges[h * NUM_EDGES], c.ep, NUM_EDGES);
+        }
+
+        memset(edgeCoset, 0xFF, sizeof(edgeCoset));
+        cosets = 0;
+        for (int i = 0; i < N_EDGE_PERM; i++)
+        {
+            if (edgeCoset[i] != 0xFF) continue;
+
+            CubieCube c; c.setUDEdgePerm(i / N_SLICE_PERM); c.setSlicePerm(i % N_SLICE_PERM);
+            for (size_t h = 0; h < g2Edges.size(); h++)
+            {
+                CubieCube r;
+                for (int j = 0; j < NUM_EDGES; j++) r.ep[j] = edges[h * NUM_EDGES + c.ep[j]];
+                edgeCoset[r.udEdgePerm() * N_SLICE_PERM + r.slicePerm()] = cosets;
+            }
+            cosets++;
+        }
+
+        // Coset move tables through one representative of each coset
+        std::vector<uint16_t> cornerRep(N_CORNER_COSETS), cornerMove(N_CORNER_COSETS * N_PHASE2_MOVES);
+        std::vector<uint32_t> edgeRep(N_EDGE_COSETS);
+        std::vector<uint16_t> edgeMove(N_EDGE_COSETS * N_PHASE2_MOVES);
+        for (int i = N_CORNER_PERM - 1; i >= 0; i--) cornerRep[cornerCoset[i]] = i;
+        for (int i = N_EDGE_PERM - 1; i >= 0; i--) edgeRep[edgeCoset[i]] = i;
+        for (int k = 0; k < N_PHASE2_MOVES; k++)
+        {
+            for (int i = 0; i < N_CORNER_COSETS; i++)
+                cornerMove[i * N_PHASE2_MOVES + k] = cornerCoset[cornerPermMove[cornerRep[i]][k]];
+            for (int i = 0; i < N_EDGE_COSETS; i++)
+                edgeMove[i * N_PHASE2_MOVES + k] = edgeCoset[moveEdgePerm(edgeRep[i], k)];
+        }
+
+        buildDistanceTable(cosetDistance, N_CORNER_COSETS, N_EDGE_COSETS, cornerMove.data(), edgeMove.data(), N_PHASE2_MOVES);
+    }
+
+    void initG2Tables()
+    {
+        std::vector<uint16_t> g2Corners = g2CornerPerms();
+        std::vector<uint32_t> g2Edges = g2EdgePerms();
+
+        memset(cornerG2Index, 0xFF, sizeof(cornerG2Index));
+        memset(edgeG2Index, 0xFF, sizeof(edgeG2Index));
+        for (size_t i = 0; i < g2Corners.size(); i++) cornerG2Index[g2Corners[i]] = i;
+        for (size_t i = 0; i < g2Edges.size(); i++) edgeG2Index[g2Edges[i]] = i;
+
+        std::vector<uint16_t> cornerMove(N_G2_CORNER_PERMS * N_HALF_TURNS), edgeMove(N_G2_EDGE_PERMS * N_HALF_TURNS);
+        for (int k = 0; k < N_HALF_TURNS; k++)
+        {
+            for (int i = 0; i < N_G2_CORNER_PERMS; i++)
+                cornerMove[i * N_HALF_TURNS + k] = cornerG2Index[cornerPermMove[g2Corners[i]][halfTurns()[k]]];
+            for (int i = 0; i < N_G2_EDGE_PERMS; i++)
+                edgeMove[i * N_HALF_TURNS + k] = edgeG2Index[moveEdgePerm(g2Edges[i], halfTurns()[k])];
+        }
+
+        buildDistanceTable(g2Distance, N_G2_CORNER_PERMS, N_G2_EDGE_PERMS, cornerMove.data(), edgeMove.data(), N_HALF_TURNS);
+    }
+
+    uint32_t moveEdgePerm(uint32_t edgePerm, int k) const
+    {
+        return udEdgePermMove[edgePerm / N_SLICE_PERM][k] * N_SLICE_PERM + slicePermMove[edgePerm % N_SLICE_PERM][k];
+    }
+
+    // Every corner permutation reachable from the identity with half turns
+    std::vector<uint16_t> g2CornerPerms() const
+    {
+        std::vector<bool> seen(N_CORNER_PERM);
+        std::vector<uint16_t> perms(1, 0);
+        seen[0] = true;
+        for (size_t i = 0; i < perms.size(); i++)
+        {
+            for (int k = 0; k < N_HALF_TURNS; k++)
+            {
+                uint16_t next = cornerPermMove[perms[i]][halfTurns()[k]];
+                if (!seen[next])
+                {
+                    seen[next] = true;
+                    perms.push_back(next);
+                }
+            }
+        }
+        return perms;
+    }
+
+    // Every edge permutation, as udEdgePerm * 24 + slicePerm, reachable with half turns
+    std::vector<uint32_t> g2EdgePerms() const
+    {
+        std::vector<bool> seen(N_EDGE_PERM);
+        std::vector<uint32_t> perms(1, 0);
+        seen[0] = true;
+        for (size_t i = 0; i < perms.size(); i++)
+        {
+            for (int k = 0; k < N_HALF_TURNS; k++)
+            {
+                uint32_t next = moveEdgePerm(perms[i], halfTurns()[k]);
+                if (!seen[next])
+                {
+                    seen[next] = true;
+                    perms.push_back(next);
+                }
+            }
+        }
+        return perms;
+    }
+
+    /** Breadth-first search over the product of two coordinates, starting from (0, 0).
+      * Unreachable entries are left at 0xFF. */
+    void buildDistanceTable(uint8_t *table, int sizeA, int sizeB, const uint16_t *moveA,
+                            const uint16_t *moveB, int numMoves)
+    {
+        memset(table, 0xFF, (size_t)sizeA * sizeB);
+
+        std::vector<uint32_t> frontier(1, 0), next;
+        table[0] = 0;
+        for (uint8_t depth = 0; !frontier.empty(); depth++)
+        {
+            next.clear();
+            for (uint32_t idx : frontier)
+            {
+                int a = idx / sizeB, b = idx % sizeB;
+                for (int m = 0; m < numMoves; m++)
+                {
+                    uint32_t nidx = moveA[a * numMoves + m] * sizeB + moveB[b * numMoves + m];
+                    if (table[nidx] == 0xFF)
+                    {
+                        table[nidx] = depth + 1;
+                        next.push_back(nidx);
+                    }
+                }
+            }
+            frontier.swap(next);
+        }
+    }
+
+};
+
+/** Fast, non-optimal solver used for scrambling. Phase 1 is searched with IDA*; the
+  * first SOLVER_PHASE1_LEAVES phase 1 solutions are finished with the exact G2 and
+  * solved-state tables and the shortest result is kept. Solutions average about 26
+  * moves. A solver holds its own search stack, so use one per thread. */
+class Solver
+{
+public:
+
+    Solver()
+        : tables(SolverTables::get())
+    {}
+
+    void solve(const CubieCube &cube, std::vector<int> &solution)
+    {
+        start = cube;
+        best.clear();
+        leavesLeft = SOLVER_PHASE1_LEAVES;
+
+        int twist = cube.twist(), flip = cube.flip(), slice = cube.slice();
+        for (int depth = phase1Heuristic(twist, flip, slice); leavesLeft > 0; depth++)
+        {
+            phase1(twist, flip, slice, depth, 0);
+        }
+        solution = best;
+    }
+
+private:
+
+    const SolverTables &tables;
+    CubieCube start;
+    std::vector<int> best, candidate;
+    int leavesLeft;
+    int path[32];
+
+    int phase1Heuristic(int twist, int flip, int slice) const
+    {
+        int a = tables.twistSlicePrune[twist * N_SLICE + slice];
+        int b = tables.flipSlicePrune[flip * N_SLICE + slice];
+        int c = tables.twistFlipPrune[twist * N_FLIP + flip];
+        if (b > a) a = b;
+        return a > c ? a : c;
+    }
+
+    static bool isPhase2Move(int m)
+    {
+        int face = m / 3;
+        return face == 0 || face == 3 || m % 3 == 1;
+    }
+
+    bool phase1(int twist, int flip, int slice, int depth, int n)
+    {
+        if (phase1Heuristic(twist, flip, slice) > depth) return false;
+
+        if (depth == 0)
+        {
+            // Phase 1 solutions ending in a G1 move were already seen one move shorter
+            if (n > 0 && isPhase2Move(path[n - 1])) return false;
+            finish(n);
+            return --leavesLeft == 0;
+        }
+
+        for (int m = 0; m < NUM_FACE_MOVES; m++)
+        {
+            // Skip a second turn of the same face, and order turns of opposite faces
+            if (n > 0 && (m / 3 == path[n - 1] / 3 || m / 3 == path[n - 1] / 3 - 3)) continue;
+
+            path[n] = m;
+            if (phase1(tables.twistMove[twist][m], tables.flipMove[flip][m], tables.sliceMove[slice][m], depth - 1, n + 1))
+                return true;
+        }
+        return false;
+    }
+
+    // Walk the exact G2 and solved-state tables from a phase 1 solution
+    void finish(int n)
+    {
+        candidate.assign(path, path + n);
+
+        CubieCube c = start;
+        for (int i = 0; i < n; i++) c.move(path[i]);
+        int cornerPerm = c.cornerPerm();
+        int edgePerm = c.udEdgePerm() * N_SLICE_PERM + c.slicePerm();
+
+        for (int d = cosetDistance(cornerPerm, edgePerm); d > 0; d--)
+        {
+            for (int k = 0; k < N_PHASE2_MOVES; k++)
+            {
+                int nextCorner = tables.cornerPermMove[cornerPerm][k];
+                int nextEdge = moveEdgePerm(edgePerm, k);
+                if (cosetDistance(nextCorner, nextEdge) == d - 1)
+                {
+                    push(SolverTables::phase2Moves()[k]);
+                    cornerPerm = nextCorner; edgePerm = nextEdge;
+                    break;
+                }
+            }
+        }
+
+        for (int d = g2Distance(cornerPerm, edgePerm); d > 0; d--)
+        {
+            for (int j = 0; j < N_HALF_TURNS; j++)
+            {
+                int k = SolverTables::halfTurns()[j];
+                int nextCorner = tables.cornerPermMove[cornerPerm][k];
+                int nextEdge = moveEdgePerm(edgePerm, k);
+                if (g2Distance(nextCorner, nextEdge) == d - 1)
+                {
+                    push(SolverTables::phase2Moves()[k]);
+                    cornerPerm = nextCorner; edgePerm = nextEdge;
+                    break;
+                }
+            }
+        }
+
+        if (leavesLeft == SOLVER_PHASE1_LEAVES || candidate.size() < best.size())
+            best = candidate;
+    }
+
+    int cosetDistance(int cornerPerm, int edgePerm) const
+    {
+        return tables.cosetDistance[tables.cornerCoset[cornerPerm] * N_EDGE_COSETS + tables.edgeCoset[edgePerm]];
+    }
+
+    int g2Distance(int cornerPerm, int edgePerm) const
+    {
+        return tables.g2Distance[tables.cornerG2Index[cornerPerm] * N_G2_EDGE_PERMS + tables.edgeG2Index[edgePerm]];
+    }
+
+    int moveEdgePerm(int edgePerm, int k) const
+    {
+        return tables.udEdgePermMove[edgePerm / N_SLICE_PERM][k] * N_SLICE_PERM + tables.slicePermMove[edgePerm % N_SLICE_PERM][k];
+    }
+
+    // Append a move, merging it with earlier turns of the same face across a commuting opposite turn
+    void push(int m)
+    {
+        int face = m / 3;
+        int n = candidate.size();
+        int i = -1;
+        if (n > 0 && candidate[n - 1] / 3 == face) i = n - 1;
+        else if (n > 1 && candidate[n - 2] / 3 == face && candidate[n - 1] / 3 % 3 == face % 3) i = n - 2;
+
+        if (i < 0)
+        {
+            candidate.push_back(m);
+            return;
+        }
+
+        int turns = (candidate[i] % 3 + 1 + m % 3 + 1) % 4;
+        if (turns == 0) candidate.erase(candidate.begin() + i);
+        else candidate[i] = face * 3 + turns - 1;
+    }
+
+};
+
+#endif
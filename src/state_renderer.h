@@ -0,0 +1,170 @@
+#ifndef STATE_RENDERER_H
+#define STATE_RENDERER_H
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <string>
+#include <thread>
+#include <vector>
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include "camera.h"
+#include "cube.h"
+#include "cube_scene.h"
+#include "gl_object.h"
+#include "png.h"
+#include "scene_renderer.h"
+#include "shader.h"
+#include "sticker_renderer.h"
+#include "window.h"
+
+/** Renders one PNG per line of a scramble list, each showing a solved cube after that
+  * scramble, named after the line's index. Lines with an unknown move are reported and
+  * skipped. Needs a current context, such as a HeadlessContext. Readback is pipelined
+  * through two pixel pack buffers: while the GPU renders state i, state i-1 is mapped
+  * and handed to an encoder thread, so PNG encoding overlaps the following renders. */
+class StateRenderer
+{
+public:
+
+    int width = 512, height = 512;
+    glm::vec3 cameraPosition = glm::vec3(0.0f, 2.0f, -2.0f);
+
+    // Returns the number of images written
+    int run(FILE *scrambles, const char *outDir)
+    {
+        glEnable(GL_DEPTH_TEST);
+        glDepthFunc(GL_LESS);
+        glEnable(GL_BLEND);
+        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+        Window target(width, height, NULL);
+        Camera camera(cameraPosition, glm::vec3(0.0f), width, height);
+        UniformBuffer frameUniforms(sizeof(FrameUniforms), FRAME_UNIFORMS_BINDING);
+        StickerRenderer stickers;
+        SceneRenderer renderer(&stickers);
+        CubeScene scene;
+        SceneSnapshot snapshot;
+        Cube &cube = scene.add(1.0f, 1);  // The seed is only for scramble, never called
+
+        // Every turn starts at 0 and the frame is drawn long after the last one ended
+        FrameUniforms frame = { camera.projectionView, camera.position, 1.0f };
+        frameUniforms.update(&frame);
+
+        size_t imageSize = (size_t)width * height * 4;
+        for (int k = 0; k < 2; k++)
+        {
+            pbo[k] = GLBuffer::create();
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, pbo[k]);
+            glBufferData(GL_PIXEL_PACK_BUFFER, imageSize, NULL, GL_STREAM_READ);
+            pixels[k].resize(imageSize);
+        }
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        glPixelStorei(GL_PACK_ALIGNMENT, 1);
+
+        std::string line;
+        std::vector<LayerMove> moves;
+        char chunk[4096];
+        int count = 0, lineNumber = 0;
+        while (fgets(chunk, sizeof(chunk), scrambles))
+        {
+            line += chunk;
+            if (line.back() != '\n' && !feof(scrambles)) continue;
+            line.erase(line.find_last_not_of("\r\n") + 1);
+            lineNumber++;
+            bool parsed = parse(line, cube.getSize(), moves);
+            line.clear();
+            if (!parsed)
+            {
+                fprintf(stderr, "Skipping line %d\n", lineNumber);
+                continue;
+            }
+
+            cube.reset();
+            cube.perFrame(0.0f);
+            cube.moveSequence(moves);
+            scene.snapshot(snapshot);
+
+            glBindFramebuffer(GL_FRAMEBUFFER, target.FBO);
+            glViewport(0, 0, width, height);
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+            renderer.render(snapshot, camera, frame.time);
+
+            // Queue the readback of this state, then collect the previous one
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, pbo[count % 2]);
+            glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, (void*)0);
+            if (count > 0) collect(count - 1, outDir);
+            imageLines[count % 2] = lineNumber - 1;
+            count++;
+        }
+        if (count > 0) collect(count - 1, outDir);
+
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        for (int k = 0; k < 2; k++)
+            if (encoders[k].joinable()) encoders[k].join();
+        return count;
+    }
+
+private:
+
+    GLBuffer pbo[2];
+    std::vector<uint8_t> pixels[2];
+    std::thread encoders[2];
+    int imageLines[2];  // Index of the line each pixel buffer holds the state of
+
+    // Splits a line into moves, false after reporting the first unknown move
+    static bool parse(const std::string &line, int cubeSize, std::vector<LayerMove> &moves)
+    {
+        moves.clear();
+        std::string token;
+        for (const char *c = line.c_str(); ; c++)
+        {
+            if (*c != '\0' && !isspace((unsigned char)*c))
+            {
+                token += *c;
+                continue;
+            }
+            if (!token.empty())
+            {
+                LayerMove move;
+                if (!LayerMove::parse(token.c_str(), cubeSize, move))
+                {
+                    fprintf(stderr, "Render: unknown move \"%s\"\n", token.c_str());
+                    return false;
+                }
+                moves.push_back(move);
+                token.clear();
+            }
+            if (*c == '\0') return true;
+        }
+    }
+
+    // Copies image i out of its pixel buffer and encodes it in the background
+    void collect(int i, const char *outDir)
+    {
+        int k = i % 2;
+        if (encoders[k].joinable()) encoders[k].join();
+
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, pbo[k]);
+        const void *mapped = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, pixels[k].size(), GL_MAP_READ_BIT);
+        if (mapped == NULL)
+        {
+            fprintf(stderr, "Error: Failed to map the pixel buffer of image %d\n", imageLines[k]);
+            return;
+        }
+        memcpy(pixels[k].data(), mapped, pixels[k].size());
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+
+        char path[4096];
+        snprintf(path, sizeof(path), "%s/%06d.png", outDir, imageLines[k]);
+        encoders[k] = std::thread([this, k, path = std::string(path)]() {
+            PNG::write(path.c_str(), pixels[k].data(), width, height, true);
+        });
+    }
+
+};
+
+#endif
@@ -0,0 +1,210 @@
+#ifndef STICKER_RENDERER_H
+#define STICKER_RENDERER_H
+
+#include <GL/glew.h>
+#include <string.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/type_ptr.hpp>
+#include "colour_scheme.h"
+#include "easing.h"
+#include "gl_object.h"
+#include "shader.h"
+
+// Stickers drawn by one instance, a batch of quads sharing one vertex buffer
+#define STICKER_BATCH 64
+
+// Texels of RGBA32F per sticker in the instance buffer texture
+#define STICKER_TEXELS 7
+
+// Intervals of the baked turn easing curve, the shader gets one more sample than that
+#define EASE_TABLE_SIZE 64
+
+// Per-sticker data, read by the vertex shader as STICKER_TEXELS texels of a buffer texture
+struct StickerInstance
+{
+    glm::mat4 model;       // Relative to the cube's origin, before the latest turn
+    glm::vec4 turn;        // Axis in xyz, angle in degrees in w
+    glm::vec4 timing;      // Start time, duration, palette index, unused
+    glm::vec4 origin;      // Centre of the cube in xyz, turns rotate about it
+};
+
+/** Everything the stickers of every puzzle share: the shader, the palette and a batch of
+  * STICKER_BATCH quads. Each instance draws one batch, its vertices fetching their sticker
+  * from a buffer texture over an instance buffer, so thousands of stickers cost a handful
+  * of instances rather than one each (per-instance setup dominates software rasterizers).
+  * Instance buffers belong to whoever draws, puzzles themselves own no GL objects. */
+class StickerRenderer
+{
+public:
+
+    StickerRenderer()
+        : shader(vertexShaderSource, fragmentShaderSource)
+    {
+        const float corners[4][2] = { { -0.5f, -0.5f }, { 0.5f, -0.5f }, { 0.5f, 0.5f }, { -0.5f, 0.5f } };
+        const GLuint quadIndices[6] = { 0, 1, 2, 2, 3, 0 };
+        float vertices[STICKER_BATCH * 4 * 2];
+        GLuint indices[STICKER_BATCH * 6];
+        for (int q = 0; q < STICKER_BATCH; q++)
+        {
+            memcpy(vertices + q * 8, corners, sizeof(corners));
+            for (int i = 0; i < 6; i++) indices[q * 6 + i] = q * 4 + quadIndices[i];
+        }
+
+        quadVBO = GLBuffer::create();
+        glBindBuffer(GL_ARRAY_BUFFER, quadVBO);
+        glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+
+        // The vertex array only holds the batch, sticker data comes from the buffer texture
+        VAO = GLVertexArray::create();
+        glBindVertexArray(VAO);
+        glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
+        glEnableVertexAttribArray(0);
+        quadEBO = GLBuffer::create();
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, quadEBO);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
+        glBindVertexArray(0);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+        // The palette and the easing curve never change. The curve is the CSS ease-in
+        float easeTable[EASE_TABLE_SIZE + 1];
+        EasingCurve(0.42f, 0.0f, 1.0f, 1.0f).bake(easeTable, EASE_TABLE_SIZE);
+        glUseProgram(shader.ID);
+        glUniform3fv(shader.uniform("palette"), NUM_COLOURS, &colourScheme[0][0]);
+        glUniform1fv(shader.uniform("easeTable"), EASE_TABLE_SIZE + 1, easeTable);
+        glUniform1i(shader.uniform("stickers"), 0);
+        glUseProgram(0);
+    }
+
+    // Buffer texture viewing instanceBuffer as StickerInstances
+    GLTexture createBufferTexture(GLuint instanceBuffer) const
+    {
+        GLTexture texture = GLTexture::create();
+        glBindTexture(GL_TEXTURE_BUFFER, texture);
+        glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, instanceBuffer);
+        glBindTexture(GL_TEXTURE_BUFFER, 0);
+        return texture;
+    }
+
+    /** Binds the program and sets the style, border width and corner radius are in sticker
+      * units. hideBackStickers skips stickers facing away from the camera, which only show
+      * through the gaps between pieces but still cost their triangles. */
+    void begin(float borderWidth, float cornerRadius, bool hideBackStickers = false) const
+    {
+        glUseProgram(shader.ID);
+        glUniform1f(shader.uniform("borderWidth"), borderWidth);
+        glUniform1f(shader.uniform("cornerRadius"), cornerRadius);
+        glUniform1i(shader.uniform("hideBackStickers"), hideBackStickers);
+    }
+
+    // Draws stickers [first, first + count) of a buffer texture from createBufferTexture
+    void drawInstances(GLuint bufferTexture, int first, int count) const
+    {
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_BUFFER, bufferTexture);
+        glUniform1i(shader.uniform("firstSticker"), first);
+        glUniform1i(shader.uniform("stickerCount"), count);
+        glBindVertexArray(VAO);
+        glDrawElementsInstanced(GL_TRIANGLES, STICKER_BATCH * 6, GL_UNSIGNED_INT, (void*)0,
+                                (count + STICKER_BATCH - 1) / STICKER_BATCH);
+        glBindVertexArray(0);
+        glBindTexture(GL_TEXTURE_BUFFER, 0);
+    }
+
+private:  // Vertex and fragments shaders
+
+    const char *vertexShaderSource = "#version 330 core\n" SHADER_DEFINE(STICKER_BATCH) SHADER_DEFINE(STICKER_TEXELS)
+                                     SHADER_DEFINE(EASE_TABLE_SIZE) R"(
+        layout(location = 0) in vec2 aPos;
+        layout(std140) uniform Frame { mat4 projectionView; vec3 cameraPosition; float time; };
+        uniform samplerBuffer stickers;  // StickerInstances, STICKER_TEXELS texels each
+        uniform int firstSticker, stickerCount;
+        uniform bool hideBackStickers;
+        uniform vec3 palette[6];
+        uniform float easeTable[EASE_TABLE_SIZE + 1];  // Samples of the turn easing curve
+        out vec3 colour;
+        out vec2 quadPos;
+
+        // The easing curve between the table's samples
+        float ease(float t) {
+            float x = t * float(EASE_TABLE_SIZE);
+            int i = min(int(x), EASE_TABLE_SIZE - 1);
+            return mix(easeTable[i], easeTable[i + 1], x - float(i));
+        }
+
+        // Rodrigues' rotation of v about the unit axis k
+        vec3 rotate(vec3 v, vec3 k, float angle) {
+            float c = cos(angle), s = sin(angle);
+            return v*c + cross(k, v)*s + k*dot(k, v)*(1.0 - c);
+        }
+
+        void main() {
+            // STICKER_BATCH quads per instance. The last batch may run past the end, its
+            // extra quads are moved out of the clip volume
+            int sticker = gl_InstanceID * STICKER_BATCH + gl_VertexID / 4;
+            if (sticker >= stickerCount) {
+                gl_Position = vec4(2.0, 2.0, 2.0, 1.0);
+                return;
+            }
+            int base = (firstSticker + sticker) * STICKER_TEXELS;
+            mat4 model = mat4(texelFetch(stickers, base), texelFetch(stickers, base + 1),
+                              texelFetch(stickers, base + 2), texelFetch(stickers, base + 3));
+            vec4 turn = texelFetch(stickers, base + 4);    // axis, angle in degrees
+            vec4 timing = texelFetch(stickers, base + 5);  // start time, duration, colour
+            vec3 origin = texelFetch(stickers, base + 6).xyz;
+
+            float t = timing.y > 0.0 ? clamp((time - timing.x) / timing.y, 0.0, 1.0) : 1.0;
+            float angle = radians(turn.w) * ease(t);
+
+            // A sticker faces along the major axis of its centre, drop those facing away
+            if (hideBackStickers) {
+                vec3 centre = model[3].xyz;
+                vec3 a = abs(centre);
+                vec3 normal = a.x >= a.y && a.x >= a.z ? vec3(sign(centre.x), 0.0, 0.0)
+                            : a.y >= a.z ? vec3(0.0, sign(centre.y), 0.0) : vec3(0.0, 0.0, sign(centre.z));
+                vec3 toCamera = cameraPosition - origin - rotate(centre, turn.xyz, angle);
+                if (dot(rotate(normal, turn.xyz, angle), toCamera) <= 0.0) {
+                    gl_Position = vec4(2.0, 2.0, 2.0, 1.0);
+                    return;
+                }
+            }
+
+            vec3 local = (model * vec4(aPos, 0.0, 1.0)).xyz;
+            vec3 world = origin + rotate(local, turn.xyz, angle);
+            gl_Position = projectionView * vec4(world, 1.0);
+            colour = palette[int(timing.z)];
+            quadPos = aPos;
+        }
+    )";
+
+    const char *fragmentShaderSource = R"(
+        #version 330 core
+        in vec3 colour;
+        in vec2 quadPos;
+        uniform float borderWidth;   // In sticker units, the quad spans [-0.5, 0.5]
+        uniform float cornerRadius;
+        out vec4 FragColor;
+
+        void main() {
+            // Signed distance to the rounded square outline, negative inside
+            vec2 q = abs(quadPos) - vec2(0.5 - cornerRadius);
+            float d = length(max(q, 0.0)) + min(max(q.x, q.y), 0.0) - cornerRadius;
+
+            // Blend over one pixel at each edge
+            float aa = fwidth(d);
+            float coverage = 1.0 - smoothstep(-aa, 0.0, d);
+            if (coverage <= 0.0) discard;
+            float fill = 1.0 - smoothstep(-borderWidth - aa, -borderWidth, d);
+            FragColor = vec4(colour * fill, coverage);
+        }
+    )";
+
+private:
+
+    Shader shader;
+    GLBuffer quadVBO, quadEBO;
+    GLVertexArray VAO;
+
+};
+
+#endif
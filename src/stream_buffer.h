@@ -0,0 +1,181 @@
+#ifndef STREAM_BUFFER_H
+#define STREAM_BUFFER_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <GL/glew.h>
+#include "gl_object.h"
+
+#define STREAM_BUFFER_REGIONS 3
+#define STREAM_BUFFER_MIN_REGION (1 << 20)
+
+/** Stall-free uploads into GPU buffers. Data is written into a staging ring and copied
+  * into its destination on the GPU, so the CPU never waits for draws still reading the
+  * destination, as glBufferSubData may.
+  *
+  * With ARB_buffer_storage the ring is mapped once, persistent and coherent, and split
+  * into STREAM_BUFFER_REGIONS regions used in turn. Each region is fenced once its copies
+  * are queued and only written again after its fence signals, which normally happened
+  * frames ago. Without it every upload maps its range unsynchronized, and the ring is
+  * orphaned instead of reused when it wraps around. */
+class StreamBuffer
+{
+public:
+
+    // Bytes uploaded in total and during the last finished frame, and times a region's
+    // fence had not signalled yet when it came round again
+    uint64_t totalBytes = 0;
+    size_t frameBytes = 0, lastFrameBytes = 0;
+    int fenceWaits = 0;
+
+    StreamBuffer() {}
+
+    ~StreamBuffer()
+    {
+        for (int r = 0; r < STREAM_BUFFER_REGIONS; r++)
+            if (fences[r]) glDeleteSync(fences[r]);
+    }
+
+    StreamBuffer(const StreamBuffer &) = delete;
+    StreamBuffer &operator=(const StreamBuffer &) = delete;
+
+    bool isPersistent() const
+    {
+        return persistent;
+    }
+
+    // Copies size bytes of data to offset in the destination buffer
+    void upload(GLuint destination, size_t offset, const void *data, size_t size)
+    {
+        if (size == 0) return;
+        if (size > regionSize) allocate(size);
+
+        GLintptr start = reserve(size);
+        glBindBuffer(GL_COPY_READ_BUFFER, ring);
+        if (persistent)
+        {
+            memcpy(mapped + start, data, size);
+        }
+        else
+        {
+            void *range = glMapBufferRange(GL_COPY_READ_BUFFER, start, size,
+                                           GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT | GL_MAP_INVALIDATE_RANGE_BIT);
+            if (range == NULL)
+            {
+                fprintf(stderr, "Error: Failed to map the stream buffer\n");
+                glBindBuffer(GL_COPY_READ_BUFFER, 0);
+                return;
+            }
+            memcpy(range, data, size);
+            glUnmapBuffer(GL_COPY_READ_BUFFER);
+        }
+
+        glBindBuffer(GL_COPY_WRITE_BUFFER, destination);
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, start, offset, size);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+        glBindBuffer(GL_COPY_READ_BUFFER, 0);
+
+        frameBytes += size;
+        totalBytes += size;
+    }
+
+    // Fences the copies queued this frame and moves on to the next region
+    void endFrame()
+    {
+        if (used > 0) nextRegion();
+        lastFrameBytes = frameBytes;
+        frameBytes = 0;
+    }
+
+private:
+
+    GLBuffer ring;
+    bool persistent = false;
+    uint8_t *mapped = NULL;
+    size_t regionSize = 0;
+
+    // Current region and how much of it is used
+    int region = 0;
+    size_t used = 0;
+    GLsync fences[STREAM_BUFFER_REGIONS] = { 0 };
+
+    // Returns where size bytes can be written, waiting for the GPU only if it must
+    GLintptr reserve(size_t size)
+    {
+        if (used + size > regionSize) nextRegion();
+        GLintptr start = region * regionSize + used;
+        used += size;
+        return start;
+    }
+
+    void nextRegion()
+    {
+        if (persistent)
+        {
+            if (fences[region]) glDeleteSync(fences[region]);
+            fences[region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        }
+        region = (region + 1) % STREAM_BUFFER_REGIONS;
+        used = 0;
+
+        if (persistent && fences[region])
+        {
+            GLenum status = glClientWaitSync(fences[region], 0, 0);
+            if (status == GL_TIMEOUT_EXPIRED)
+            {
+                fenceWaits++;
+                do status = glClientWaitSync(fences[region], GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+                while (status == GL_TIMEOUT_EXPIRED);
+            }
+            glDeleteSync(fences[region]);
+            fences[region] = 0;
+        }
+        else if (!persistent && region == 0)
+        {
+            // Orphan the whole ring, copies still reading the old storage keep it alive
+            glBindBuffer(GL_COPY_READ_BUFFER, ring);
+            glBufferData(GL_COPY_READ_BUFFER, STREAM_BUFFER_REGIONS * regionSize, NULL, GL_STREAM_DRAW);
+            glBindBuffer(GL_COPY_READ_BUFFER, 0);
+        }
+    }
+
+    // (Re)creates the ring with regions of at least minimum bytes
+    void allocate(size_t minimum)
+    {
+        regionSize = STREAM_BUFFER_MIN_REGION;
+        while (regionSize < minimum) regionSize *= 2;
+
+        // Copies already queued keep reading the old ring until they are done
+        for (int r = 0; r < STREAM_BUFFER_REGIONS; r++)
+        {
+            if (fences[r]) glDeleteSync(fences[r]);
+            fences[r] = 0;
+        }
+        region = 0;
+        used = 0;
+
+        ring = GLBuffer::create();
+        glBindBuffer(GL_COPY_READ_BUFFER, ring);
+        persistent = GLEW_ARB_buffer_storage;
+        if (persistent)
+        {
+            const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+            glBufferStorage(GL_COPY_READ_BUFFER, STREAM_BUFFER_REGIONS * regionSize, NULL, flags);
+            mapped = (uint8_t*)glMapBufferRange(GL_COPY_READ_BUFFER, 0, STREAM_BUFFER_REGIONS * regionSize, flags);
+            if (mapped == NULL)
+            {
+                fprintf(stderr, "Warning: Persistent mapping failed, streaming through unsynchronized maps\n");
+                persistent = false;
+                ring = GLBuffer::create();
+                glBindBuffer(GL_COPY_READ_BUFFER, ring);
+            }
+        }
+        if (!persistent)
+            glBufferData(GL_COPY_READ_BUFFER, STREAM_BUFFER_REGIONS * regionSize, NULL, GL_STREAM_DRAW);
+        glBindBuffer(GL_COPY_READ_BUFFER, 0);
+    }
+
+};
+
+#endif
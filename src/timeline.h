@@ -0,0 +1,132 @@
+#ifndef TIMELINE_H
+#define TIMELINE_H
+
+#include <ctype.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string>
+#include <vector>
+#include "cube_scene.h"
+#include "facelet_cube.h"
+
+// Moves between stored states
+#define TIMELINE_KEYFRAME_INTERVAL 256
+
+/** A long move sequence that can be sought to any move. The state before every
+  * keyframeInterval-th move is stored packed, two stickers a byte, so seeking restores
+  * the nearest one before it and replays at most keyframeInterval - 1 moves, however
+  * long the sequence. Position 0 is the start, position size() the end. */
+class Timeline
+{
+public:
+
+    Timeline(int cubeSize = 3, int keyframeInterval = TIMELINE_KEYFRAME_INTERVAL)
+        : cubeSize(cubeSize)
+        , keyframeInterval(keyframeInterval < 1 ? 1 : keyframeInterval)
+    {}
+
+    /** Parses a whitespace separated sequence in LayerMove's notation, starting from
+      * start, and stores its keyframes. Unknown moves are reported and skipped. Returns
+      * the number of moves kept. */
+    int build(const char *sequence, const FaceletCube &start)
+    {
+        cubeSize = start.getSize();
+        moves.clear();
+        keyframes.clear();
+
+        FaceletCube state = start;
+        std::vector<uint8_t> packed(state.packedSize());
+        std::string token;
+        for (const char *c = sequence; ; c++)
+        {
+            if (*c != '\0' && !isspace((unsigned char)*c))
+            {
+                token += *c;
+                continue;
+            }
+            if (!token.empty())
+            {
+                LayerMove move;
+                if (LayerMove::parse(token.c_str(), cubeSize, move))
+                {
+                    if (moves.size() % keyframeInterval == 0)
+                    {
+                        state.pack(packed.data());
+                        keyframes.insert(keyframes.end(), packed.begin(), packed.end());
+                    }
+                    state.apply(move);
+                    moves.push_back(move);
+                }
+                else fprintf(stderr, "Timeline: skipping unknown move \"%s\"\n", token.c_str());
+                token.clear();
+            }
+            if (*c == '\0') break;
+        }
+        if (moves.size() % keyframeInterval == 0)
+        {
+            state.pack(packed.data());
+            keyframes.insert(keyframes.end(), packed.begin(), packed.end());
+        }
+        position = 0;
+        return moves.size();
+    }
+
+    int size() const
+    {
+        return moves.size();
+    }
+
+    int getPosition() const
+    {
+        return position;
+    }
+
+    const LayerMove &move(int i) const
+    {
+        return moves[i];
+    }
+
+    // The state after the first position moves, in O(keyframeInterval) moves
+    void seek(int target, FaceletCube &out) const
+    {
+        if (target < 0) target = 0;
+        if (target > size()) target = size();
+
+        int keyframe = target / keyframeInterval;
+        if (out.getSize() != cubeSize) out = FaceletCube(cubeSize);
+        out.unpack(keyframes.data() + (size_t)keyframe * FaceletCube::packedSize(cubeSize));
+        for (int i = keyframe * keyframeInterval; i < target; i++) out.apply(moves[i]);
+    }
+
+    /** Shows position target on every cube of the timeline's size. A step forward is
+      * animated, as the next move, anything else jumps straight to the state. */
+    void playTo(CubeScene &scene, int target)
+    {
+        if (target < 0) target = 0;
+        if (target > size()) target = size();
+        if (target == position) return;
+
+        bool step = target == position + 1;
+        if (!step) seek(target, scratch);
+        for (int i = 0; i < scene.size(); i++)
+        {
+            Cube &cube = scene.cube(i);
+            if (cube.getSize() != cubeSize) continue;
+            if (step) cube.move(moves[position]);
+            else      cube.setState(scratch);
+        }
+        position = target;
+    }
+
+private:
+
+    int cubeSize;
+    int keyframeInterval;
+    std::vector<LayerMove> moves;
+    std::vector<uint8_t> keyframes;  // Packed states before moves 0, K, 2K... and at the end on a multiple of K
+    int position = 0;
+    FaceletCube scratch;
+
+};
+
+#endif
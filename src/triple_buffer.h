@@ -0,0 +1,56 @@
+#ifndef TRIPLE_BUFFER_H
+#define TRIPLE_BUFFER_H
+
+#include <atomic>
+
+/** Lock-free handoff of the latest value from one producer thread to one consumer
+  * thread. Of the three slots the producer fills one, the consumer reads another and the
+  * third holds the latest published value; publishing and consuming swap a slot with
+  * that one, so neither side ever waits for the other. A value published while the
+  * previous one was still unread replaces it, the consumer always gets the newest.
+  *
+  * Slots are reused, so the producer finds whatever it published two swaps earlier in
+  * the slot it gets back, and must bring it up to date rather than assume it is empty. */
+template <typename T>
+class TripleBuffer
+{
+public:
+
+    // Producer: the slot to fill, then publish
+    T &back()
+    {
+        return slots[backIndex];
+    }
+
+    void publish()
+    {
+        int old = ready.exchange(backIndex | FRESH, std::memory_order_acq_rel);
+        backIndex = old & INDEX;
+    }
+
+    // Consumer: takes the latest value if one was published since, returns whether it did
+    bool consume()
+    {
+        if (!(ready.load(std::memory_order_relaxed) & FRESH)) return false;
+        int old = ready.exchange(frontIndex, std::memory_order_acq_rel);
+        frontIndex = old & INDEX;
+        return true;
+    }
+
+    // Consumer: the value taken by the last consume, unchanged until the next one
+    const T &front() const
+    {
+        return slots[frontIndex];
+    }
+
+private:
+
+    enum { INDEX = 3, FRESH = 4 };
+
+    T slots[3];
+    int backIndex = 0, frontIndex = 1;
+    std::atomic<int> ready { 2 };
+
+};
+
+#endif
@@ -5,16 +5,27 @@
 #include <GLFW/glfw3.h>
 #include <glm/glm.hpp>
 #include <stdio.h>
+#include "gl_object.h"
 #include <iostream>
 
+#define WINDOW_MIN_SIZE_CLASS 256
+#define WINDOW_SHRINK_DELAY 2.0f
+
+/** Offscreen target the cube is drawn into. Its texture and depth buffer are allocated
+  * in size classes 25% apart, at least the window's size, and the window renders into
+  * the bottom left width x height of them. Resizing within a class only moves the
+  * viewport, and a smaller class is only taken once the size held still for
+  * WINDOW_SHRINK_DELAY seconds, so a drag-resize doesn't reallocate every frame. */
 class Window
 {
 public:
 
-    int width, height;
-    double aspectRatio;
-    GLuint texture, FBO, DRB;
-    void (*resizeCallbak)(int, int);
+    int width = 0, height = 0;
+    double aspectRatio = 0.0;
+    GLTexture texture;
+    GLFramebuffer FBO;
+    GLRenderbuffer DRB;
+    void (*resizeCallbak)(int, int) = nullptr;
 
     Window () {}
 
@@ -25,67 +36,89 @@ public:
         , resizeCallbak(resizeCallbak)
     { initFBO(); }
 
-    ~Window()
-    {
-        glDeleteFramebuffers(1, &FBO);
-        glDeleteTextures(1, &texture);
-        glDeleteRenderbuffers(1, &DRB);
-    }
-
-    void updateDimensions(int newWidth, int newHeight)
+    void updateDimensions(int newWidth, int newHeight, double currentTime = 0.0)
     {
         width = newWidth;
         height = newHeight;
         glViewport(0, 0, width, height);
         aspectRatio = width / (float)height;
+        lastResize = currentTime;
 
-        // Update texture size
-        glBindTexture(GL_TEXTURE_2D, texture);
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-        glBindTexture(GL_TEXTURE_2D, 0);
-
-        // Update depth buffer size
-        glBindRenderbuffer(GL_RENDERBUFFER, DRB);
-        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT, width, height);
-        glBindRenderbuffer(GL_RENDERBUFFER, 0);
-
-        // Re-attach texture and depth buffer to FBO
-        glBindFramebuffer(GL_FRAMEBUFFER, FBO);
-        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture, 0);
-        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, DRB);
-        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        // Only grow here, shrinking waits for perFrame
+        if (width > textureWidth || height > textureHeight)
+            allocate(glm::max(sizeClass(width), textureWidth), glm::max(sizeClass(height), textureHeight));
 
         // Invoke the window resize callback function from parent class
-        resizeCallbak(newWidth, newHeight);
+        if (resizeCallbak) resizeCallbak(newWidth, newHeight);
     }
 
+    // Drops to smaller size classes once the size has settled. Returns true if it did,
+    // the texture then has to be drawn again
+    bool perFrame(double currentTime)
+    {
+        if (currentTime - lastResize < WINDOW_SHRINK_DELAY) return false;
+        if (sizeClass(width) >= textureWidth && sizeClass(height) >= textureHeight) return false;
+        allocate(sizeClass(width), sizeClass(height));
+        return true;
+    }
 
     glm::ivec2 resolution() const
     {
         return glm::ivec2(width, height);
     }
 
+    glm::ivec2 textureSize() const
+    {
+        return glm::ivec2(textureWidth, textureHeight);
+    }
+
+    // Texture coordinates of the top right corner of the rendered area
+    glm::vec2 uvScale() const
+    {
+        return glm::vec2(width / (float)textureWidth, height / (float)textureHeight);
+    }
+
 private:
 
+    int textureWidth = 0, textureHeight = 0;
+    double lastResize = 0.0;
+
+    static int sizeClass(int size)
+    {
+        int rounded = WINDOW_MIN_SIZE_CLASS;
+        while (rounded < size) rounded = (rounded * 5 / 4 + 15) & ~15;
+        return rounded;
+    }
+
     void initFBO()
     {
         // Create FBO, texture, and depth buffer
-        glGenFramebuffers(1, &FBO);
-        glGenTextures(1, &texture);
-        glGenRenderbuffers(1, &DRB);
+        FBO = GLFramebuffer::create();
+        texture = GLTexture::create();
+        DRB = GLRenderbuffer::create();
 
         // Set texture parameters
         glBindTexture(GL_TEXTURE_2D, texture);
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glBindTexture(GL_TEXTURE_2D, 0);
+
+        allocate(sizeClass(width), sizeClass(height));
+    }
+
+    void allocate(int newWidth, int newHeight)
+    {
+        textureWidth = newWidth;
+        textureHeight = newHeight;
+
+        glBindTexture(GL_TEXTURE_2D, texture);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, textureWidth, textureHeight, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+        glBindTexture(GL_TEXTURE_2D, 0);
 
-        // Set depth buffer parameters
         glBindRenderbuffer(GL_RENDERBUFFER, DRB);
-        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT, width, height);
-        
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT, textureWidth, textureHeight);
+        glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
         // Attach texture and depth buffer to FBO
         glBindFramebuffer(GL_FRAMEBUFFER, FBO);
         glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, DRB);
@@ -95,9 +128,6 @@ private:
         {
             fprintf(stderr, "Frame buffer not complete\n");
         }
-        
-        // Unbind texture and frame buffers
-        glBindTexture(GL_TEXTURE_2D, 0);
         glBindFramebuffer(GL_FRAMEBUFFER, 0);
     }
 